@@ -70,9 +70,8 @@ SOFTWARE.
 #define stricmp _stricmp
 #include <cctype>
 // this option need c++17
-#ifdef USE_STD_FILESYSTEM
-#include <windows.h>
-#else                       // USE_STD_FILESYSTEM
+#include <windows.h>       // also GetFileAttributesExW, for write times finer than _stat64's seconds
+#ifndef USE_STD_FILESYSTEM
 #include "dirent/dirent.h"  // directly open the dirent file attached to this lib
 #endif                      // USE_STD_FILESYSTEM
 #define PATH_SEP '\\'
@@ -116,7 +115,7 @@ SOFTWARE.
 // STB IMAGE LIBS
 ///////////////////////////////
 
-#ifdef USE_THUMBNAILS
+#if defined(USE_THUMBNAILS) && !defined(USE_THUMBNAILS_CUSTOM_LOADER)
 #ifndef DONT_DEFINE_AGAIN__STB_IMAGE_IMPLEMENTATION
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -129,7 +128,7 @@ SOFTWARE.
 #endif  // STB_IMAGE_RESIZE_IMPLEMENTATION
 #endif  // DONT_DEFINE_AGAIN__STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "stb/stb_image_resize2.h"
-#endif  // USE_THUMBNAILS
+#endif  // USE_THUMBNAILS && !USE_THUMBNAILS_CUSTOM_LOADER
 
 ///////////////////////////////
 // FLOAT MACROS
@@ -436,6 +435,30 @@ public:
 };
 
 #ifndef CUSTOM_FILESYSTEM_INCLUDE
+
+// last write time of a path in nanoseconds since the unix epoch, as fine as the platform keeps it:
+// 100 ns on windows, 1 ns on linux and macos, 1 s elsewhere. shared by both backends so the listing
+// cache can compare it with the current time
+static bool getModificationTimeNs(const std::string& vPath, int64_t& voTime) {
+#ifdef _IGFD_WIN_
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(IGFD::Utils::UTF8Decode(vPath).c_str(), GetFileExInfoStandard, &data)) return false;
+    const int64_t ticks = (int64_t)(((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime);
+    voTime = (ticks - 116444736000000000LL) * 100;  // 100 ns ticks since 1601-01-01
+#else
+    struct stat statInfos{};
+    if (stat(vPath.c_str(), &statInfos)) return false;
+#if defined(__linux__)
+    voTime = (int64_t)statInfos.st_mtim.tv_sec * 1000000000 + (int64_t)statInfos.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+    voTime = (int64_t)statInfos.st_mtimespec.tv_sec * 1000000000 + (int64_t)statInfos.st_mtimespec.tv_nsec;
+#else
+    voTime = (int64_t)statInfos.st_mtime * 1000000000;
+#endif
+#endif
+    return true;
+}
+
 #ifdef USE_STD_FILESYSTEM
 
 static std::filesystem::path stringToPath(const std::string& str) {
@@ -611,8 +634,14 @@ public:
             const auto sctp          = std::chrono::time_point_cast<std::chrono::system_clock::duration>(  //
                 lastWriteTime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
             const auto cftime        = std::chrono::system_clock::to_time_t(sctp);
-            static char timebuf[100];
-            std::strftime(timebuf, sizeof(timebuf), DateTimeFormat, std::localtime(&cftime));
+            char timebuf[100] = "";  // not static: also called from the scan thread
+#ifdef _MSC_VER
+            struct tm _tm;
+            if (!localtime_s(&_tm, &cftime)) std::strftime(timebuf, sizeof(timebuf), DateTimeFormat, &_tm);
+#else   // _MSC_VER
+            struct tm _tm;
+            if (localtime_r(&cftime, &_tm)) std::strftime(timebuf, sizeof(timebuf), DateTimeFormat, &_tm);
+#endif  // _MSC_VER
             voDate = timebuf;
             // size
             if (!vFileType.isDir()) {
@@ -623,6 +652,9 @@ public:
             voDate.clear();
         }
     }
+    bool GetModificationTime(const std::string& vPath, int64_t& voTime) override {
+        return getModificationTimeNs(vPath, voTime);  // file_time_type has no portable epoch before c++20
+    }
 };
 #define FILE_SYSTEM_OVERRIDE FileSystemStd
 #else
@@ -832,7 +864,7 @@ public:
 #else
         result = stat(vFilePathName.c_str(), &statInfos);
 #endif
-        static char timebuf[100];
+        char timebuf[100];  // not static: also called from the scan thread
         if (!result) {
             // date
             size_t len = 0;
@@ -841,8 +873,8 @@ public:
             errno_t err = localtime_s(&_tm, &statInfos.st_mtime);
             if (!err) len = strftime(timebuf, 99, DateTimeFormat, &_tm);
 #else   // _MSC_VER
-            struct tm* _tm = localtime(&statInfos.st_mtime);
-            if (_tm) len = strftime(timebuf, 99, DateTimeFormat, _tm);
+            struct tm _tm;
+            if (localtime_r(&statInfos.st_mtime, &_tm)) len = strftime(timebuf, 99, DateTimeFormat, &_tm);
 #endif  // _MSC_VER
             if (len) {
                 voDate = std::string(timebuf, len);
@@ -853,6 +885,10 @@ public:
             }
         }
     }
+    bool GetModificationTime(const std::string& vPath, int64_t& voTime) override {
+        // not _wstati64: its whole seconds would hide a file added in the same second as the cached listing
+        return getModificationTimeNs(vPath, voTime);
+    }
 };
 #define FILE_SYSTEM_OVERRIDE FileSystemDirent
 #endif  // USE_STD_FILESYSTEM
@@ -1838,6 +1874,195 @@ bool IGFD::FileInfos::FinalizeFileTypeParsing(const size_t& vMaxDotToExtract) {
     return false;
 }
 
+void IGFD::FileSearchIndex::Invalidate() {
+    m_Built = false;
+}
+
+void IGFD::FileSearchIndex::m_Build(const std::vector<std::shared_ptr<FileInfos> >& vFileInfosList) {
+    m_LowerNames.clear();
+    m_Names.clear();
+    m_Offsets.clear();
+    m_DotDots.clear();
+    m_LowerCharCounts.fill(0U);
+    m_CharCounts.fill(0U);
+    m_Offsets.reserve(vFileInfosList.size());
+    for (size_t idx = 0U; idx < vFileInfosList.size(); ++idx) {
+        const auto& file = vFileInfosList[idx];
+        m_Offsets.push_back(m_Names.size());
+        if (file.use_count()) {
+            if (file->fileNameExt_optimized == "..") m_DotDots.push_back(idx);
+            m_LowerNames += file->fileNameExt_optimized;
+            m_Names += file->fileNameExt;
+        }
+        // LowerCaseString keeps the length, the two buffers stay aligned
+        m_LowerNames.resize(m_Names.size());
+        m_LowerNames.push_back('\0');
+        m_Names.push_back('\0');
+    }
+    for (const auto& c : m_LowerNames) ++m_LowerCharCounts[(uint8_t)c];
+    for (const auto& c : m_Names) ++m_CharCounts[(uint8_t)c];
+    m_LastTag.clear();
+    m_Built = true;
+}
+
+const std::vector<size_t>& IGFD::FileSearchIndex::Search(const std::vector<std::shared_ptr<FileInfos> >& vFileInfosList, const std::string& vTag) {
+    if (!m_Built || m_Offsets.size() != vFileInfosList.size()) {
+        m_Build(vFileInfosList);
+    }
+
+    // FileInfos::SearchForTag looks for the tag in the lowercase name, then in the name as is. the lowercase names hold
+    // no upper case letter : a tag with one can only match as is, and a tag without any, if found as is, is also found
+    // in lowercase. so one buffer is enough
+    const bool lowerTag    = vTag == Utils::LowerCaseString(vTag);
+    const std::string& buf = lowerTag ? m_LowerNames : m_Names;
+    const auto& charCounts = lowerTag ? m_LowerCharCounts : m_CharCounts;
+
+    if (!m_LastTag.empty() && vTag.find(m_LastTag) != std::string::npos && m_Matches.size() * 4U < m_Offsets.size()) {
+        // the query grew : what matches now matched before, only the previous matches are tested again.
+        // when they are most of the list, the pass over the whole buffer below is quicker than one test per entry
+        size_t count = 0U;
+        for (const auto& idx : m_Matches) {
+            if (strstr(buf.c_str() + m_Offsets[idx], vTag.c_str()) != nullptr ||  //
+                std::binary_search(m_DotDots.begin(), m_DotDots.end(), idx)) {
+                m_Matches[count++] = idx;
+            }
+        }
+        m_Matches.resize(count);
+    } else {
+        // one pass over the whole buffer : memchr on the char of the tag that is the rarest in the names, then
+        // a compare of the whole tag around it. each hit is mapped back to its entry and the scan jumps to the next one.
+        // the names are '\0' separated, a tag cant span two of them
+        m_Matches.clear();
+        size_t anchor = 0U;
+        for (size_t i = 1U; i < vTag.size(); ++i) {
+            if (charCounts[(uint8_t)vTag[i]] < charCounts[(uint8_t)vTag[anchor]]) anchor = i;
+        }
+        const char* begin = buf.data();
+        const char* end   = begin + buf.size();
+        const char* p     = begin + anchor;
+        size_t idx        = 0U;
+        while (p < end && (p = (const char*)memchr(p, vTag[anchor], (size_t)(end - p))) != nullptr) {
+            const char* start = p - anchor;
+            if ((size_t)(end - start) >= vTag.size() && memcmp(start, vTag.data(), vTag.size()) == 0) {
+                const size_t pos = (size_t)(start - begin);
+                while (idx + 1U < m_Offsets.size() && m_Offsets[idx + 1U] <= pos) ++idx;  // hits come in order : one walk over the offsets in all
+                m_Matches.push_back(idx);
+                p = ((idx + 1U < m_Offsets.size()) ? begin + m_Offsets[idx + 1U] : end) + anchor;
+            } else {
+                ++p;
+            }
+        }
+        for (const auto& dotdot : m_DotDots) {  // ".." is always shown
+            const auto it = std::lower_bound(m_Matches.begin(), m_Matches.end(), dotdot);
+            if (it == m_Matches.end() || *it != dotdot) m_Matches.insert(it, dotdot);
+        }
+    }
+    m_LastTag = vTag;
+    return m_Matches;
+}
+
+bool IGFD::ListingCache::Find(const std::string& vPath, int64_t vModifTime, std::vector<Entry>& voEntries) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Directories.find(vPath);
+    if (it == m_Directories.end() || it->second.modifTime != vModifTime) return false;
+    it->second.lastUse = ++m_UseCounter;
+    voEntries          = it->second.entries;
+    return true;
+}
+
+void IGFD::ListingCache::Store(const std::string& vPath, int64_t vModifTime, const std::vector<Entry>& vEntries) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto& dir     = m_Directories[vPath];
+    dir.modifTime = vModifTime;
+    dir.lastUse   = ++m_UseCounter;
+    dir.entries   = vEntries;
+    m_Trim();
+}
+
+void IGFD::ListingCache::SetMaxDirectories(size_t vCount) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_MaxDirectories = vCount;
+    m_Trim();
+}
+
+void IGFD::ListingCache::Clear() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Directories.clear();
+}
+
+void IGFD::ListingCache::m_Trim() {
+    while (m_Directories.size() > m_MaxDirectories) {
+        auto oldest = m_Directories.begin();
+        for (auto it = m_Directories.begin(); it != m_Directories.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse) oldest = it;
+        }
+        m_Directories.erase(oldest);
+    }
+}
+
+// one line per directory ("D", time, path) followed by one line per entry (content type, symlink, stat-ed, size, date, name),
+// tab separated. a directory with a tab or a line feed in its path or in one of its names is not saved
+std::string IGFD::ListingCache::Serialize() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::ostringstream res;
+    res << "IGFD_LISTING_CACHE 2\n";
+    for (const auto& dir : m_Directories) {
+        bool savable = dir.first.find_first_of("\t\n") == std::string::npos;
+        for (size_t i = 0; savable && i < dir.second.entries.size(); ++i) {
+            savable = dir.second.entries[i].name.find_first_of("\t\n") == std::string::npos;
+        }
+        if (!savable) continue;
+        res << "D\t" << dir.second.modifTime << "\t" << dir.first << "\n";
+        for (const auto& entry : dir.second.entries) {
+            const int content = entry.fileType.isDir() ? 0 : entry.fileType.isFile() ? 1 : entry.fileType.isLinkToUnknown() ? 2 : -1;
+            res << content << "\t" << (entry.fileType.isSymLink() ? 1 : 0) << "\t" << (entry.hasStat ? 1 : 0) << "\t"  //
+                << entry.size << "\t" << entry.date << "\t" << entry.name << "\n";
+        }
+    }
+    return res.str();
+}
+
+void IGFD::ListingCache::Deserialize(const std::string& vDatas) {
+    std::istringstream in(vDatas);
+    std::string line;
+    if (!std::getline(in, line) || line != "IGFD_LISTING_CACHE 2") return;  // other format or version (1: times in other units): start empty
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Directory* dir = nullptr;
+    while (std::getline(in, line)) {
+        // splits the first vCount tab separated fields, the rest of the line (a path or a name) goes in the last one
+        std::vector<std::string> fields;
+        size_t start = 0U;
+        const size_t count = (!line.empty() && line[0] == 'D') ? 2U : 5U;
+        while (fields.size() < count) {
+            const size_t tab = line.find('\t', start);
+            if (tab == std::string::npos) break;
+            fields.push_back(line.substr(start, tab - start));
+            start = tab + 1;
+        }
+        if (fields.size() < count) continue;
+        fields.push_back(line.substr(start));
+
+        if (count == 2U) {
+            dir            = &m_Directories[fields[2]];
+            dir->modifTime = (int64_t)std::strtoll(fields[1].c_str(), nullptr, 10);
+            dir->lastUse   = ++m_UseCounter;
+            dir->entries.clear();
+        } else if (dir != nullptr) {
+            Entry entry;
+            const int content = std::atoi(fields[0].c_str());
+            if (content < 0 || content > 2) continue;
+            entry.fileType = FileType((FileType::ContentType)content, fields[1] == "1");
+            entry.hasStat  = fields[2] == "1";
+            entry.size     = (size_t)std::strtoull(fields[3].c_str(), nullptr, 10);
+            entry.date     = fields[4];
+            entry.name     = fields[5];
+            dir->entries.push_back(entry);
+        }
+    }
+    m_Trim();
+}
+
 IGFD::FileManager::FileManager() {
     fsRoot = IGFD::Utils::GetPathSeparator();
 #define STR(x) #x
@@ -1848,6 +2073,14 @@ IGFD::FileManager::FileManager() {
     // std::make_unique is not available un cpp11
     m_FileSystemPtr = std::unique_ptr<FILE_SYSTEM_OVERRIDE>(new FILE_SYSTEM_OVERRIDE());
     // m_FileSystemPtr = std::make_unique<FILE_SYSTEM_OVERRIDE>();
+    m_ListingCache = std::make_shared<ListingCache>();
+}
+
+IGFD::FileManager::~FileManager() {
+    m_CancelScan();
+    for (auto& worker : m_ScanThreads) {
+        worker.second.join();
+    }
 }
 
 void IGFD::FileManager::OpenCurrentPath(const FileDialogInternal& vFileDialogInternal) {
@@ -1878,7 +2111,8 @@ bool IGFD::FileManager::M_SortStrings(const FileDialogInternal& vFileDialogInter
     }
 }
 
-void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogInternal, std::vector<std::shared_ptr<FileInfos> >& vFileInfosList, std::vector<std::shared_ptr<FileInfos> >& vFileInfosFilteredList) {
+void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogInternal, std::vector<std::shared_ptr<FileInfos> >& vFileInfosList, std::vector<std::shared_ptr<FileInfos> >& vFileInfosFilteredList, size_t vSortedCount) {
+    std::function<bool(const std::shared_ptr<FileInfos>&, const std::shared_ptr<FileInfos>&)> comparator;
     if (sortingField != SortingFieldEnum::FIELD_NONE) {
         headerFileName = tableHeaderFileNameString;
         headerFileType = tableHeaderFileTypeString;
@@ -1892,83 +2126,81 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
         if (sortingDirection[0]) {
 #ifdef USE_CUSTOM_SORTING_ICON
             headerFileName = tableHeaderAscendingIcon + headerFileName;
-#endif                                                               // USE_CUSTOM_SORTING_ICON
-            std::sort(vFileInfosList.begin(), vFileInfosList.end(),  //
-                      [&vFileDialogInternal](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
-                          if (!a.use_count() || !b.use_count()) return false;
-                          if (a->fileType != b->fileType) return (a->fileType < b->fileType);                      // directories first
-                          return M_SortStrings(vFileDialogInternal, true, false, a->fileNameExt, b->fileNameExt);  // sort in insensitive case
-                      });
+#endif  // USE_CUSTOM_SORTING_ICON
+            comparator = [&vFileDialogInternal](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+                if (!a.use_count() || !b.use_count()) return false;
+                if (a->fileType != b->fileType) return (a->fileType < b->fileType);                      // directories first
+                return M_SortStrings(vFileDialogInternal, true, false, a->fileNameExt, b->fileNameExt);  // sort in insensitive case
+            };
         } else {
 #ifdef USE_CUSTOM_SORTING_ICON
             headerFileName = tableHeaderDescendingIcon + headerFileName;
-#endif                                                               // USE_CUSTOM_SORTING_ICON
-            std::sort(vFileInfosList.begin(), vFileInfosList.end(),  //
-                      [&vFileDialogInternal](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
-                          if (!a.use_count() || !b.use_count()) return false;
-                          if (a->fileType != b->fileType) return (a->fileType > b->fileType);                     // directories last
-                          return M_SortStrings(vFileDialogInternal, true, true, a->fileNameExt, b->fileNameExt);  // sort in insensitive case
-                      });
+#endif  // USE_CUSTOM_SORTING_ICON
+            comparator = [&vFileDialogInternal](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+                if (!a.use_count() || !b.use_count()) return false;
+                if (a->fileType != b->fileType) return (a->fileType > b->fileType);                     // directories last
+                return M_SortStrings(vFileDialogInternal, true, true, a->fileNameExt, b->fileNameExt);  // sort in insensitive case
+            };
         }
     } else if (sortingField == SortingFieldEnum::FIELD_TYPE) {
         if (sortingDirection[1]) {
 #ifdef USE_CUSTOM_SORTING_ICON
             headerFileType = tableHeaderAscendingIcon + headerFileType;
 #endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(vFileInfosList.begin(), vFileInfosList.end(), [&vFileDialogInternal](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+            comparator = [&vFileDialogInternal](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                 if (!a.use_count() || !b.use_count()) return false;
                 if (a->fileType != b->fileType) return (a->fileType < b->fileType);                                // directory in first
                 return M_SortStrings(vFileDialogInternal, true, false, a->fileExtLevels[0], b->fileExtLevels[0]);  // sort in sensitive case
-            });
+            };
         } else {
 #ifdef USE_CUSTOM_SORTING_ICON
             headerFileType = tableHeaderDescendingIcon + headerFileType;
 #endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(vFileInfosList.begin(), vFileInfosList.end(), [&vFileDialogInternal](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+            comparator = [&vFileDialogInternal](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                 if (!a.use_count() || !b.use_count()) return false;
                 if (a->fileType != b->fileType) return (a->fileType > b->fileType);                               // directory in last
                 return M_SortStrings(vFileDialogInternal, true, true, a->fileExtLevels[0], b->fileExtLevels[0]);  // sort in sensitive case
-            });
+            };
         }
     } else if (sortingField == SortingFieldEnum::FIELD_SIZE) {
         if (sortingDirection[2]) {
 #ifdef USE_CUSTOM_SORTING_ICON
             headerFileSize = tableHeaderAscendingIcon + headerFileSize;
 #endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+            comparator = [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                 if (!a.use_count() || !b.use_count()) return false;
                 if (a->fileType != b->fileType) return (a->fileType < b->fileType);  // directory in first
                 return (a->fileSize < b->fileSize);                                  // else
-            });
+            };
         } else {
 #ifdef USE_CUSTOM_SORTING_ICON
             headerFileSize = tableHeaderDescendingIcon + headerFileSize;
 #endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+            comparator = [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                 if (!a.use_count() || !b.use_count()) return false;
                 if (a->fileType != b->fileType) return (a->fileType > b->fileType);  // directory in last
                 return (a->fileSize > b->fileSize);                                  // else
-            });
+            };
         }
     } else if (sortingField == SortingFieldEnum::FIELD_DATE) {
         if (sortingDirection[3]) {
 #ifdef USE_CUSTOM_SORTING_ICON
             headerFileDate = tableHeaderAscendingIcon + headerFileDate;
 #endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+            comparator = [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                 if (!a.use_count() || !b.use_count()) return false;
                 if (a->fileType != b->fileType) return (a->fileType < b->fileType);  // directory in first
                 return (a->fileModifDate < b->fileModifDate);                        // else
-            });
+            };
         } else {
 #ifdef USE_CUSTOM_SORTING_ICON
             headerFileDate = tableHeaderDescendingIcon + headerFileDate;
 #endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+            comparator = [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                 if (!a.use_count() || !b.use_count()) return false;
                 if (a->fileType != b->fileType) return (a->fileType > b->fileType);  // directory in last
                 return (a->fileModifDate > b->fileModifDate);                        // else
-            });
+            };
         }
     }
 #ifdef USE_THUMBNAILS
@@ -1981,31 +2213,47 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
 #ifdef USE_CUSTOM_SORTING_ICON
             headerFileThumbnails = tableHeaderAscendingIcon + headerFileThumbnails;
 #endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+            comparator = [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                 if (!a.use_count() || !b.use_count()) return false;
                 if (a->fileType != b->fileType) return (a->fileType.isDir());  // directory in first
                 if (a->thumbnailInfo.textureWidth == b->thumbnailInfo.textureWidth) return (a->thumbnailInfo.textureHeight < b->thumbnailInfo.textureHeight);
                 return (a->thumbnailInfo.textureWidth < b->thumbnailInfo.textureWidth);
-            });
+            };
         }
 
         else {
 #ifdef USE_CUSTOM_SORTING_ICON
             headerFileThumbnails = tableHeaderDescendingIcon + headerFileThumbnails;
 #endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+            comparator = [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                 if (!a.use_count() || !b.use_count()) return false;
                 if (a->fileType != b->fileType) return (!a->fileType.isDir());  // directory in last
                 if (a->thumbnailInfo.textureWidth == b->thumbnailInfo.textureWidth) return (a->thumbnailInfo.textureHeight > b->thumbnailInfo.textureHeight);
                 return (a->thumbnailInfo.textureWidth > b->thumbnailInfo.textureWidth);
-            });
+            };
         }
     }
 #endif  // USE_THUMBNAILS
 
+    if (comparator) {
+        if (vSortedCount > 0U && vSortedCount <= vFileInfosList.size()) {
+            // only the new entries are sorted, then merged with the sorted head : linear instead of n log n for each batch of a scan
+            const auto middle = vFileInfosList.begin() + (std::ptrdiff_t)vSortedCount;
+            std::sort(middle, vFileInfosList.end(), comparator);
+            std::inplace_merge(vFileInfosList.begin(), middle, vFileInfosList.end(), comparator);
+        } else {
+            std::sort(vFileInfosList.begin(), vFileInfosList.end(), comparator);
+        }
+    }
+    m_GetSearchIndex(vFileInfosList).Invalidate();
+
     m_ApplyFilteringOnFileList(vFileDialogInternal, vFileInfosList, vFileInfosFilteredList);
 }
 
+IGFD::FileSearchIndex& IGFD::FileManager::m_GetSearchIndex(const std::vector<std::shared_ptr<FileInfos> >& vFileInfosList) {
+    return (&vFileInfosList == &m_PathList) ? m_PathSearchIndex : m_FileSearchIndex;
+}
+
 bool IGFD::FileManager::m_CompleteFileInfosWithUserFileAttirbutes(const FileDialogInternal& vFileDialogInternal, const std::shared_ptr<FileInfos>& vInfos) {
     if (vFileDialogInternal.getDialogConfig().userFileAttributes != nullptr) {
         if (!vFileDialogInternal.getDialogConfig().userFileAttributes(vInfos.get(), vFileDialogInternal.getDialogConfig().userDatas)) {
@@ -2020,18 +2268,23 @@ bool IGFD::FileManager::m_CompleteFileInfosWithUserFileAttirbutes(const FileDial
 }
 
 void IGFD::FileManager::ClearFileLists() {
+    m_CancelScan();
     m_FilteredFileList.clear();
     m_FileList.clear();
+    m_FileSearchIndex.Invalidate();
+    m_ScanSortedCount = 0U;
     m_SelectedFileNames.clear();
 }
 
 void IGFD::FileManager::ClearPathLists() {
     m_FilteredPathList.clear();
     m_PathList.clear();
+    m_PathSearchIndex.Invalidate();
     m_SelectedFileNames.clear();
 }
 
-void IGFD::FileManager::m_AddFile(const FileDialogInternal& vFileDialogInternal, const std::string& vPath, const std::string& vFileName, const FileType& vFileType) {
+std::shared_ptr<IGFD::FileInfos> IGFD::FileManager::M_CreateFileInfos(const FilterManager& vFilters, ImGuiFileDialogFlags vFlags, IFileSystem* vFileSystem,  //
+                                                                      const std::string& vPath, const std::string& vFileName, const FileType& vFileType) {
     auto pInfos = FileInfos::create();
 
     pInfos->filePath              = vPath;
@@ -2039,28 +2292,34 @@ void IGFD::FileManager::m_AddFile(const FileDialogInternal& vFileDialogInternal,
     pInfos->fileNameExt_optimized = Utils::LowerCaseString(pInfos->fileNameExt);
     pInfos->fileType              = vFileType;
 
-    if (pInfos->fileNameExt.empty() || (pInfos->fileNameExt == "." && !vFileDialogInternal.filterManager.dLGFilters.empty())) {  // filename empty or filename is the current dir '.' //-V807
-        return;
+    if (pInfos->fileNameExt.empty() || (pInfos->fileNameExt == "." && !vFilters.dLGFilters.empty())) {  // filename empty or filename is the current dir '.' //-V807
+        return nullptr;
     }
 
-    if (pInfos->fileNameExt != ".." && (vFileDialogInternal.getDialogConfig().flags & ImGuiFileDialogFlags_DontShowHiddenFiles) && pInfos->fileNameExt[0] == '.') {  // dont show hidden files
-        if (!vFileDialogInternal.filterManager.dLGFilters.empty() || (vFileDialogInternal.filterManager.dLGFilters.empty() && pInfos->fileNameExt != ".")) {            // except "." if in directory mode //-V728
-            return;
+    if (pInfos->fileNameExt != ".." && (vFlags & ImGuiFileDialogFlags_DontShowHiddenFiles) && pInfos->fileNameExt[0] == '.') {  // dont show hidden files
+        if (!vFilters.dLGFilters.empty() || (vFilters.dLGFilters.empty() && pInfos->fileNameExt != ".")) {                      // except "." if in directory mode //-V728
+            return nullptr;
         }
     }
 
-    if (pInfos->FinalizeFileTypeParsing(vFileDialogInternal.filterManager.GetSelectedFilter().count_dots)) {
-        if (!vFileDialogInternal.filterManager.IsCoveredByFilters(*pInfos.get(),  //
-                                                                  (vFileDialogInternal.getDialogConfig().flags & ImGuiFileDialogFlags_CaseInsensitiveExtentionFiltering) != 0)) {
-            return;
+    if (pInfos->FinalizeFileTypeParsing(vFilters.GetSelectedFilter().count_dots)) {
+        if (!vFilters.IsCoveredByFilters(*pInfos.get(), (vFlags & ImGuiFileDialogFlags_CaseInsensitiveExtentionFiltering) != 0)) {
+            return nullptr;
         }
     }
 
-    vFileDialogInternal.filterManager.FillFileStyle(pInfos);
+    vFilters.FillFileStyle(pInfos);
 
-    m_CompleteFileInfos(pInfos);
+    if (vFileSystem != nullptr) {  // null when size and date come from the listing cache
+        M_CompleteFileInfos(vFileSystem, pInfos);
+    }
 
-    if (m_CompleteFileInfosWithUserFileAttirbutes(vFileDialogInternal, pInfos)) {
+    return pInfos;
+}
+
+void IGFD::FileManager::m_AddFile(const FileDialogInternal& vFileDialogInternal, const std::string& vPath, const std::string& vFileName, const FileType& vFileType) {
+    auto pInfos = M_CreateFileInfos(vFileDialogInternal.filterManager, vFileDialogInternal.getDialogConfig().flags, m_FileSystemPtr.get(), vPath, vFileName, vFileType);
+    if (pInfos != nullptr && m_CompleteFileInfosWithUserFileAttirbutes(vFileDialogInternal, pInfos)) {
         m_FileList.push_back(pInfos);
     }
 }
@@ -2110,13 +2369,137 @@ void IGFD::FileManager::ScanDir(const FileDialogInternal& vFileDialogInternal, c
 
         ClearFileLists();
 
-        const auto& files = m_FileSystemPtr->ScanDirectory(path);
+        // listing and stat-ing a big (or network mounted) directory can take seconds: done on a worker,
+        // the entries show up frame after frame through UpdateScan
+        auto job     = std::make_shared<ScanJob>();
+        job->path    = path;
+        job->filters = vFileDialogInternal.filterManager;
+        job->flags   = vFileDialogInternal.getDialogConfig().flags;
+        m_ScanJob    = job;
+        m_ScanThreads.emplace_back(job, std::thread(&IGFD::FileManager::M_ScanWorker, m_FileSystemPtr.get(), m_ListingCache, job));
+        m_LastScanSort = std::chrono::steady_clock::now();
+
+        m_SortFields(vFileDialogInternal, m_FileList, m_FilteredFileList);
+    }
+}
+
+void IGFD::FileManager::M_ScanWorker(IFileSystem* vFileSystem, std::shared_ptr<ListingCache> vCache, std::shared_ptr<ScanJob> vJob) {
+    const size_t batchSize = 256U;
+    std::vector<std::shared_ptr<FileInfos> > batch;
+
+    // an unchanged directory comes straight from the listing cache. otherwise it is listed and stat-ed again:
+    // the listing is the cost worth saving, and reusing old stats would keep a file first seen half-copied
+    // at its partial size for good
+    int64_t modifTime  = 0;
+    const bool useCache = vCache != nullptr && vFileSystem->GetModificationTime(vJob->path, modifTime);
+    // a directory changed in the last 2 s may change again without its time moving (fat and smb keep 2 s,
+    // some backends whole seconds), so a listing taken now could miss a file for good: it is not cached
+    const int64_t now = (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    const bool settled = now - modifTime > 2000000000LL;
+    std::vector<ListingCache::Entry> entries;
+    bool changed = false;
+    if (!useCache || !vCache->Find(vJob->path, modifTime, entries)) {
+        const auto files = vFileSystem->ScanDirectory(vJob->path);
+        entries.reserve(files.size());
         for (const auto& file : files) {
-            m_AddFile(vFileDialogInternal, path, file.fileNameExt, file.fileType);
+            ListingCache::Entry entry;
+            entry.name     = file.fileNameExt;
+            entry.fileType = file.fileType;
+            entries.push_back(entry);
         }
+        changed = true;
+    }
 
-        m_SortFields(vFileDialogInternal, m_FileList, m_FilteredFileList);
+    for (auto& entry : entries) {
+        if (vJob->cancel) break;
+        auto pInfos = M_CreateFileInfos(vJob->filters, vJob->flags, entry.hasStat ? nullptr : vFileSystem, vJob->path, entry.name, entry.fileType);
+        if (pInfos != nullptr) {
+            if (entry.hasStat) {
+                pInfos->fileSize      = entry.size;
+                pInfos->fileModifDate = entry.date;
+                if (!pInfos->fileType.isDir()) {
+                    pInfos->formatedFileSize = IGFD::Utils::FormatFileSize(pInfos->fileSize);
+                }
+            } else {
+                entry.hasStat = true;
+                entry.size    = pInfos->fileSize;
+                entry.date    = pInfos->fileModifDate;
+                changed       = true;
+            }
+            batch.push_back(pInfos);
+        }
+        if (batch.size() >= batchSize) {
+            std::lock_guard<std::mutex> lock(vJob->pendingMutex);
+            vJob->pending.insert(vJob->pending.end(), batch.begin(), batch.end());
+            batch.clear();
+        }
     }
+    if (useCache && settled && changed && !vJob->cancel) {
+        vCache->Store(vJob->path, modifTime, entries);
+    }
+    std::lock_guard<std::mutex> lock(vJob->pendingMutex);
+    vJob->pending.insert(vJob->pending.end(), batch.begin(), batch.end());
+    vJob->done = true;
+}
+
+void IGFD::FileManager::UpdateScan(const FileDialogInternal& vFileDialogInternal) {
+    // join the workers of finished or cancelled scans
+    for (auto it = m_ScanThreads.begin(); it != m_ScanThreads.end();) {
+        if (it->first->done) {
+            it->second.join();
+            it = m_ScanThreads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (m_ScanJob == nullptr || m_ScanJob->consumed) return;
+
+    std::vector<std::shared_ptr<FileInfos> > batch;
+    bool done = false;
+    {
+        std::lock_guard<std::mutex> lock(m_ScanJob->pendingMutex);
+        batch.swap(m_ScanJob->pending);
+        done = m_ScanJob->done;
+    }
+    for (const auto& pInfos : batch) {
+        if (m_CompleteFileInfosWithUserFileAttirbutes(vFileDialogInternal, pInfos)) {
+            m_FileList.push_back(pInfos);
+        }
+    }
+    m_ScanJob->found += batch.size();
+
+    // sorting the growing list on every batch would cost more than the scan itself: a few times per second is enough
+    const auto now = std::chrono::steady_clock::now();
+    if (done || (!batch.empty() && now - m_LastScanSort > std::chrono::milliseconds(250))) {
+        m_SortFields(vFileDialogInternal, m_FileList, m_FilteredFileList, m_ScanSortedCount);
+        m_ScanSortedCount = m_FileList.size();
+        m_LastScanSort    = now;
+    }
+    m_ScanJob->consumed = done;
+}
+
+void IGFD::FileManager::m_CancelScan() {
+    if (m_ScanJob != nullptr) {
+        m_ScanJob->cancel = true;
+        m_ScanJob         = nullptr;
+    }
+}
+
+bool IGFD::FileManager::IsScanning() const {
+    return m_ScanJob != nullptr && !m_ScanJob->consumed;
+}
+
+bool IGFD::FileManager::IsScanStarted() const {
+    return m_ScanJob != nullptr;
+}
+
+size_t IGFD::FileManager::GetScannedCount() const {
+    return m_ScanJob != nullptr ? m_ScanJob->found : 0U;
+}
+
+IGFD::ListingCache& IGFD::FileManager::GetListingCache() {
+    return *m_ListingCache;
 }
 
 void IGFD::FileManager::m_ScanDirForPathSelection(const FileDialogInternal& vFileDialogInternal, const std::string& vPath) {
@@ -2247,17 +2630,27 @@ void IGFD::FileManager::ApplyFilteringOnFileList(const FileDialogInternal& vFile
 
 void IGFD::FileManager::m_ApplyFilteringOnFileList(const FileDialogInternal& vFileDialogInternal, std::vector<std::shared_ptr<FileInfos> >& vFileInfosList, std::vector<std::shared_ptr<FileInfos> >& vFileInfosFilteredList) {
     vFileInfosFilteredList.clear();
-    for (const auto& file : vFileInfosList) {
-        if (!file.use_count()) continue;
-        bool show = true;
-        if (!file->SearchForTag(vFileDialogInternal.searchManager.searchTag))  // if search tag
-            show = false;
-        if (dLGDirectoryMode && !file->fileType.isDir()) show = false;
-        if (show) vFileInfosFilteredList.push_back(file);
+    const auto& tag = vFileDialogInternal.searchManager.searchTag;
+    if (tag.empty()) {
+        for (const auto& file : vFileInfosList) {
+            if (!file.use_count()) continue;
+            if (dLGDirectoryMode && !file->fileType.isDir()) continue;
+            vFileInfosFilteredList.push_back(file);
+        }
+    } else {  // same result as FileInfos::SearchForTag on each entry
+        for (const auto& idx : m_GetSearchIndex(vFileInfosList).Search(vFileInfosList, tag)) {
+            const auto& file = vFileInfosList[idx];
+            if (dLGDirectoryMode && !file->fileType.isDir()) continue;
+            vFileInfosFilteredList.push_back(file);
+        }
     }
 }
 
 void IGFD::FileManager::m_CompleteFileInfos(const std::shared_ptr<FileInfos>& vInfos) {
+    M_CompleteFileInfos(m_FileSystemPtr.get(), vInfos);
+}
+
+void IGFD::FileManager::M_CompleteFileInfos(IFileSystem* vFileSystem, const std::shared_ptr<FileInfos>& vInfos) {
     if (!vInfos.use_count()) return;
 
     if ((vInfos->fileNameExt == ".") ||   // current dir (special case, not really a dir or a file)
@@ -2287,7 +2680,7 @@ void IGFD::FileManager::m_CompleteFileInfos(const std::shared_ptr<FileInfos>& vI
         fpn = vInfos->filePath + IGFD::Utils::GetPathSeparator() + vInfos->fileNameExt;
     }
 
-    m_FileSystemPtr->GetFileDateAndSize(fpn, vInfos->fileType, vInfos->fileModifDate, vInfos->fileSize);
+    vFileSystem->GetFileDateAndSize(fpn, vInfos->fileType, vInfos->fileModifDate, vInfos->fileSize);
 
     if (!vInfos->fileType.isDir()) {
         vInfos->formatedFileSize = IGFD::Utils::FormatFileSize(vInfos->fileSize);
@@ -2777,6 +3170,7 @@ void IGFD::FileDialogInternal::NewFrame() {
     isOk                       = false;  // reset dialog result
     fileManager.devicesClicked = false;
     fileManager.pathClicked    = false;
+    fileManager.UpdateScan(*this);
 
     needToExitDialog = false;
 
@@ -2891,13 +3285,13 @@ IGFD::ThumbnailFeature::ThumbnailFeature() {
 IGFD::ThumbnailFeature::~ThumbnailFeature() = default;
 
 void IGFD::ThumbnailFeature::m_NewThumbnailFrame(FileDialogInternal& /*vFileDialogInternal*/) {
-#ifdef USE_THUMBNAILS
+#if defined(USE_THUMBNAILS) && !defined(USE_THUMBNAILS_CUSTOM_LOADER)
     m_StartThumbnailFileDatasExtraction();
 #endif
 }
 
 void IGFD::ThumbnailFeature::m_EndThumbnailFrame(FileDialogInternal& vFileDialogInternal) {
-#ifdef USE_THUMBNAILS
+#if defined(USE_THUMBNAILS) && !defined(USE_THUMBNAILS_CUSTOM_LOADER)  // custom loader: the application owns the textures
     m_ClearThumbnails(vFileDialogInternal);
 #else
     (void)vFileDialogInternal;
@@ -2905,7 +3299,7 @@ void IGFD::ThumbnailFeature::m_EndThumbnailFrame(FileDialogInternal& vFileDialog
 }
 
 void IGFD::ThumbnailFeature::m_QuitThumbnailFrame(FileDialogInternal& vFileDialogInternal) {
-#ifdef USE_THUMBNAILS
+#if defined(USE_THUMBNAILS) && !defined(USE_THUMBNAILS_CUSTOM_LOADER)
     m_StopThumbnailFileDatasExtraction();
     m_ClearThumbnails(vFileDialogInternal);
 #else
@@ -2938,6 +3332,7 @@ bool IGFD::ThumbnailFeature::m_StopThumbnailFileDatasExtraction() {
 }
 
 void IGFD::ThumbnailFeature::m_ThreadThumbnailFileDatasExtractionFunc() {
+#ifndef USE_THUMBNAILS_CUSTOM_LOADER
     m_CountFiles = 0U;
     m_IsWorking  = true;
     // infinite loop while is thread working
@@ -3000,6 +3395,7 @@ void IGFD::ThumbnailFeature::m_ThreadThumbnailFileDatasExtractionFunc() {
             thumbnailFileDatasToGetLock.unlock();
         }
     }
+#endif  // USE_THUMBNAILS_CUSTOM_LOADER
 }
 
 void IGFD::ThumbnailFeature::m_VariadicProgressBar(float fraction, const ImVec2& size_arg, const char* fmt, ...) {
@@ -3099,6 +3495,10 @@ void IGFD::ThumbnailFeature::SetDestroyThumbnailCallback(const DestroyThumbnailF
     m_DestroyThumbnailFun = vCreateThumbnailFun;
 }
 
+void IGFD::ThumbnailFeature::SetRequestThumbnailCallback(const RequestThumbnailFun& vRequestThumbnailFun) {
+    m_RequestThumbnailFun = vRequestThumbnailFun;
+}
+
 void IGFD::ThumbnailFeature::ManageGPUThumbnails() {
     if (m_CreateThumbnailFun) {
         m_ThumbnailToCreateMutex.lock();
@@ -3860,7 +4260,7 @@ bool IGFD::FileDialog::Display(const std::string& vKey, ImGuiWindowFlags vFlags,
                 fdFilter.SetDefaultFilterIfNotDefined();
 
                 // init list of files
-                if (fdFile.IsFileListEmpty() && !fdFile.showDevices) {
+                if (fdFile.IsFileListEmpty() && !fdFile.showDevices && !fdFile.IsScanStarted()) {
                     if (fdFile.dLGpath != ".")                                                      // Removes extension seperator in filename if we don't check
                         IGFD::Utils::ReplaceString(fdFile.dLGDefaultFileName, fdFile.dLGpath, "");  // local path
 
@@ -3952,6 +4352,11 @@ void IGFD::FileDialog::m_DrawHeader() {
 #endif  // USE_THUMBNAILS
 
     m_FileDialogInternal.searchManager.DrawSearchBar(m_FileDialogInternal);
+
+    if (m_FileDialogInternal.fileManager.IsScanning()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Scanning... %u", (unsigned)m_FileDialogInternal.fileManager.GetScannedCount());
+    }
 }
 
 void IGFD::FileDialog::m_DrawContent() {
@@ -4631,11 +5036,19 @@ void IGFD::FileDialog::m_DrawThumbnailsListView(ImVec2 vSize) {
                     if (ImGui::TableNextColumn()) {  // file thumbnails
                         auto th = &pInfos->thumbnailInfo;
 
+#ifdef USE_THUMBNAILS_CUSTOM_LOADER
+                        // only rows kept by the clipper get here, so the application sees what is on screen
+                        if (m_RequestThumbnailFun && pInfos->fileType.isFile()) {
+                            m_RequestThumbnailFun(pInfos->filePath + IGFD::Utils::GetPathSeparator() + pInfos->fileNameExt, th);
+                        }
+#else   // USE_THUMBNAILS_CUSTOM_LOADER
                         if (!th->isLoadingOrLoaded) {
                             m_AddThumbnailToLoad(pInfos);
                         }
+#endif  // USE_THUMBNAILS_CUSTOM_LOADER
                         if (th->isReadyToDisplay && th->textureID) {
-                            ImGui::Image((ImTextureID)th->textureID, ImVec2((float)th->textureWidth, (float)th->textureHeight));
+                            ImGui::Image((ImTextureID)th->textureID, ImVec2((float)th->textureWidth, (float)th->textureHeight),  //
+                                         ImVec2(th->uv0[0], th->uv0[1]), ImVec2(th->uv1[0], th->uv1[1]));
                         }
                         m_DisplayFileInfosTooltip(i, column_id, pInfos);
                     }
@@ -4735,6 +5148,14 @@ std::string IGFD::FileDialog::GetCurrentFilter() {
     return m_FileDialogInternal.filterManager.GetSelectedFilter().title;
 }
 
+std::string IGFD::FileDialog::SerializeListingCache() {
+    return m_FileDialogInternal.fileManager.GetListingCache().Serialize();
+}
+
+void IGFD::FileDialog::DeserializeListingCache(const std::string& vListings) {
+    m_FileDialogInternal.fileManager.GetListingCache().Deserialize(vListings);
+}
+
 std::map<std::string, std::string> IGFD::FileDialog::GetSelection(IGFD_ResultMode vFlag) {
     return m_FileDialogInternal.fileManager.GetResultingSelection(m_FileDialogInternal, vFlag);
 }
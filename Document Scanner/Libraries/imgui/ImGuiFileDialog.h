@@ -183,6 +183,8 @@ struct IGFD_Thumbnail_Info {
     unsigned char* textureFileDatas = 0;  // file texture datas, will be rested to null after gpu upload
     void* textureID                 = 0;  // 2d texture id (void* is like ImtextureID type) (GL, DX, VK, Etc..)
     void* userDatas                 = 0;  // user datas
+    float uv0[2]                    = {0.0f, 0.0f};  // sub rect of textureID to display (for texture atlases)
+    float uv1[2]                    = {1.0f, 1.0f};
 };
 #endif  // USE_THUMBNAILS
 
@@ -207,6 +209,8 @@ struct IGFD_Thumbnail_Info {
 #include <regex>
 #include <array>
 #include <mutex>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <thread>
 #include <cfloat>
@@ -531,6 +535,70 @@ public:
     virtual std::vector<IGFD::PathDisplayedName> GetDevicesList() = 0;
     // return via argument the date and the size of a file (for solve issue regarding apis and widechars)
     virtual void GetFileDateAndSize(const std::string& vFilePathName, const IGFD::FileType& vFileType, std::string& voDate, size_t& voSize) = 0;
+    // return via argument the last modification time of a path in nanoseconds since the unix epoch (the resolution may be
+    // coarser). false if unknown, in which case the listing cache is not used for this path
+    virtual bool GetModificationTime(const std::string& /*vPath*/, int64_t& /*voTime*/) { return false; }
+};
+
+// search index over a file list. the names are packed in two flat buffers (lowercase and as is, each name followed
+// by a '\0'), so a search is a scan over contiguous memory instead of two finds per entry through its FileInfos.
+// a query that only grew from the previous one (the usual typing case) is refined from the previous matches
+class IGFD_API FileSearchIndex {
+private:
+    std::string m_LowerNames;       // FileInfos::fileNameExt_optimized of each entry, '\0' terminated
+    std::string m_Names;            // FileInfos::fileNameExt of each entry, same offsets
+    std::vector<size_t> m_Offsets;  // start of each entry in the two buffers
+    std::vector<size_t> m_DotDots;  // ".." entries, always matching
+    std::array<size_t, 256> m_LowerCharCounts{};  // occurrences of each char in m_LowerNames
+    std::array<size_t, 256> m_CharCounts{};       // occurrences of each char in m_Names
+    std::vector<size_t> m_Matches;  // entries matching m_LastTag
+    std::string m_LastTag;
+    bool m_Built = false;
+
+private:
+    void m_Build(const std::vector<std::shared_ptr<FileInfos> >& vFileInfosList);
+
+public:
+    void Invalidate();  // the list was refilled or reordered
+    const std::vector<size_t>& Search(const std::vector<std::shared_ptr<FileInfos> >& vFileInfosList, const std::string& vTag);  // indices of the matching entries, in list order
+};
+
+// directory listings kept between scans, keyed by path and validated by the modification time of the directory.
+// an unchanged directory is served from here without listing or stat-ing anything; a changed one is listed and every
+// entry stat-ed again. can be saved and reloaded across runs (see FileDialog::SerializeListingCache)
+// note: a file rewritten in place does not touch its directory, so its size and date stay as cached until the directory
+// changes (a file is added, removed or renamed in it)
+class IGFD_API ListingCache {
+public:
+    struct Entry {
+        std::string name;
+        FileType fileType;
+        bool hasStat = false;  // size and date known (stat-ed once a filter let the file through)
+        size_t size  = 0U;
+        std::string date;
+    };
+
+private:
+    struct Directory {
+        int64_t modifTime = 0;
+        uint64_t lastUse  = 0U;
+        std::vector<Entry> entries;
+    };
+    std::mutex m_Mutex;  // used from the scan threads
+    std::unordered_map<std::string, Directory> m_Directories;
+    uint64_t m_UseCounter = 0U;
+    size_t m_MaxDirectories = 64U;
+
+private:
+    void m_Trim();  // drop the least recently used directories beyond the max
+
+public:
+    bool Find(const std::string& vPath, int64_t vModifTime, std::vector<Entry>& voEntries);  // true if cached for exactly this time
+    void Store(const std::string& vPath, int64_t vModifTime, const std::vector<Entry>& vEntries);
+    void SetMaxDirectories(size_t vCount);
+    void Clear();
+    std::string Serialize();                      // text buffer to save in a file
+    void Deserialize(const std::string& vDatas);  // buffer saved by Serialize(), merged into the cache
 };
 
 class IGFD_API FileManager {
@@ -559,6 +627,27 @@ private:
     std::string m_FileSystemName;
     std::unique_ptr<IFileSystem> m_FileSystemPtr = nullptr;
 
+    // directory listing running on a worker thread. the worker does the slow part (listing, filtering, stat)
+    // on a snapshot of the filters and hands finished entries over in batches; the ui thread takes them in UpdateScan
+    struct ScanJob {
+        std::string path;
+        FilterManager filters;                               // snapshot, the dialog may change its filters meanwhile
+        ImGuiFileDialogFlags flags = ImGuiFileDialogFlags_None;
+        std::atomic<bool> cancel{false};
+        std::atomic<bool> done{false};
+        std::mutex pendingMutex;
+        std::vector<std::shared_ptr<FileInfos> > pending;  // entries not yet taken by the ui thread
+        size_t found  = 0;                                 // entries taken so far (ui thread only)
+        bool consumed = false;                             // done and everything taken (ui thread only)
+    };
+    std::shared_ptr<ScanJob> m_ScanJob;                                               // current scan, null if none
+    std::vector<std::pair<std::shared_ptr<ScanJob>, std::thread> > m_ScanThreads;  // workers not joined yet
+    std::chrono::steady_clock::time_point m_LastScanSort;
+    std::shared_ptr<ListingCache> m_ListingCache;  // shared with the scan threads, which may outlive a scan
+    size_t m_ScanSortedCount = 0U;                 // head of m_FileList already sorted while the scan goes on
+    FileSearchIndex m_FileSearchIndex;             // for m_FileList
+    FileSearchIndex m_PathSearchIndex;             // for m_PathList
+
 public:
     bool inputPathActivated                               = false;  // show input for path edition
     bool devicesClicked                                   = false;  // event when a drive button is clicked
@@ -607,11 +696,22 @@ private:
                               const bool vInsensitiveCase, const bool vDescendingOrder,  //
                               const std::string& vA, const std::string& vB);
     void m_SortFields(const FileDialogInternal& vFileDialogInternal, std::vector<std::shared_ptr<FileInfos> >& vFileInfosList,
-                      std::vector<std::shared_ptr<FileInfos> >& vFileInfosFilteredList);  // will sort a column
+                      std::vector<std::shared_ptr<FileInfos> >& vFileInfosFilteredList,
+                      size_t vSortedCount = 0U);  // will sort a column. the first vSortedCount entries are already sorted the same way
+    FileSearchIndex& m_GetSearchIndex(const std::vector<std::shared_ptr<FileInfos> >& vFileInfosList);
     bool m_CompleteFileInfosWithUserFileAttirbutes(const FileDialogInternal& vFileDialogInternal, const std::shared_ptr<FileInfos>& vInfos);
+    static std::shared_ptr<FileInfos> M_CreateFileInfos(const FilterManager& vFilters, ImGuiFileDialogFlags vFlags, IFileSystem* vFileSystem,  //
+                                                        const std::string& vPath, const std::string& vFileName,
+                                                        const FileType& vFileType);  // null if filtered out, else styled and stat-ed
+    static void M_CompleteFileInfos(IFileSystem* vFileSystem, const std::shared_ptr<FileInfos>& vInfos);
+    static void M_ScanWorker(IFileSystem* vFileSystem, std::shared_ptr<ListingCache> vCache, std::shared_ptr<ScanJob> vJob);  // body of the scan thread
+    void m_CancelScan();                                                                                                     // stop the current scan, if any
 
 public:
     FileManager();
+    ~FileManager();
+    FileManager(const FileManager&)            = delete;
+    FileManager& operator=(const FileManager&) = delete;
     bool IsComposerEmpty() const;
     size_t GetComposerSize() const;
     bool IsFileListEmpty() const;
@@ -647,7 +747,12 @@ public:
     void SelectOrDeselectFileName(const FileDialogInternal& vFileDialogInternal, const std::shared_ptr<FileInfos>& vInfos);  // add/remove a filename in selection
     void SetCurrentDir(const std::string& vPath);                                                                            // define current directory for scan
     void ScanDir(const FileDialogInternal& vFileDialogInternal,
-                 const std::string& vPath);  // scan the directory for retrieve the file list
+                 const std::string& vPath);  // start scanning the directory in the background for retrieve the file list
+    void UpdateScan(const FileDialogInternal& vFileDialogInternal);  // take the entries found by the background scan, called each frame
+    bool IsScanning() const;                                         // a background scan is still running
+    bool IsScanStarted() const;                                      // a scan was started since the file list was last cleared
+    size_t GetScannedCount() const;                                  // entries found by the current scan so far
+    ListingCache& GetListingCache();                                 // listings of the directories scanned before
     std::string GetResultingPath();
     std::string GetResultingFileName(FileDialogInternal& vFileDialogInternal, IGFD_ResultMode vFlag);
     std::string GetResultingFilePathName(FileDialogInternal& vFileDialogInternal, IGFD_ResultMode vFlag);
@@ -735,6 +840,7 @@ protected:
 public:
     typedef std::function<void(IGFD_Thumbnail_Info*)> CreateThumbnailFun;   // texture 2d creation function binding
     typedef std::function<void(IGFD_Thumbnail_Info*)> DestroyThumbnailFun;  // texture 2d destroy function binding
+    typedef std::function<void(const std::string&, IGFD_Thumbnail_Info*)> RequestThumbnailFun;  // called each frame per visible file (file path name, infos to fill)
 
 protected:
     enum class DisplayModeEnum { FILE_LIST = 0, THUMBNAILS_LIST, THUMBNAILS_GRID };
@@ -755,6 +861,7 @@ private:
     DestroyThumbnailFun m_DestroyThumbnailFun = nullptr;
 
 protected:
+    RequestThumbnailFun m_RequestThumbnailFun = nullptr;
     DisplayModeEnum m_DisplayMode = DisplayModeEnum::FILE_LIST;
 
 private:
@@ -775,6 +882,7 @@ protected:
 public:
     void SetCreateThumbnailCallback(const CreateThumbnailFun& vCreateThumbnailFun);
     void SetDestroyThumbnailCallback(const DestroyThumbnailFun& vCreateThumbnailFun);
+    void SetRequestThumbnailCallback(const RequestThumbnailFun& vRequestThumbnailFun);  // USE_THUMBNAILS_CUSTOM_LOADER
 
     // must be call in gpu zone (rendering, possibly one rendering thread)
     void ManageGPUThumbnails();  // in gpu rendering zone, whill create or destroy texture
@@ -961,6 +1069,10 @@ public:
     std::string GetCurrentFilter();                                                                          // will return current filter
     UserDatas GetUserDatas() const;                                                                          // will return user datas send with Open Dialog
 
+    // directory listing cache
+    std::string SerializeListingCache();                        // serialize the listings of the directories already scanned, to save in a file
+    void DeserializeListingCache(const std::string& vListings);  // load listings saved with SerializeListingCache() by a previous run
+
     // file style by extentions
     void SetFileStyle(                                        // SetExtention datas for have custom display of particular file type
         const IGFD_FileStyleFlags& vFlags,                    // file style
@@ -35,14 +35,17 @@
 //// THUMBNAILS /////////////////
 /////////////////////////////////
 
-// #define USE_THUMBNAILS
+#define USE_THUMBNAILS
+// the application produces the thumbnails (decoding, textures) through SetRequestThumbnailCallback,
+// called for the rows visible in the thumbnails list. the stb based loader thread is not compiled
+#define USE_THUMBNAILS_CUSTOM_LOADER
 // the thumbnail generation use the stb_image and stb_resize lib who need to define the implementation
 // btw if you already use them in your app, you can have compiler error due to "implemntation found in double"
 // so uncomment these line for prevent the creation of implementation of these libs again
 // #define DONT_DEFINE_AGAIN__STB_IMAGE_IMPLEMENTATION
 // #define DONT_DEFINE_AGAIN__STB_IMAGE_RESIZE_IMPLEMENTATION
 // #define IMGUI_RADIO_BUTTON RadioButton
-// #define DisplayMode_ThumbailsList_ImageHeight 32.0f
+#define DisplayMode_ThumbailsList_ImageHeight 64.0f
 // #define tableHeaderFileThumbnailsString "Thumbnails"
 // #define DisplayMode_FilesList_ButtonString "FL"
 // #define DisplayMode_FilesList_ButtonHelp "File List"
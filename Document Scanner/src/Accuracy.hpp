@@ -0,0 +1,144 @@
+// Accuracy.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "Core.hpp"
+#include "Detection.hpp"
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    // A detection variant under test: image in, quad out (any corner order).
+    struct DetectorVariant {
+        string name;
+        function<bool(const Mat& img, vector<Point2f>& quad)> detect;
+    };
+
+    struct LabelledImage {
+        string file;
+        vector<Point2f> quad; // TL, TR, BR, BL
+    };
+
+    struct AccuracyRow {
+        string variant;
+        int images = 0, detected = 0, hits = 0;
+        double meanCornerErrPx = 0, meanCornerErrPct = 0, meanIoU = 0, meanMs = 0;
+    };
+
+    vector<DetectorVariant> defaultDetectorVariants() {
+        vector<DetectorVariant> v;
+        v.push_back({ "contour", [](const Mat& img, vector<Point2f>& q) {
+            return findDocumentContour(preProcessForContours(img), q); } });
+        v.push_back({ "contour@600", [](const Mat& img, vector<Point2f>& q) {
+            return detectOnProxy(img, q, 600); } });
+        v.push_back({ "lines@600", [](const Mat& img, vector<Point2f>& q) {
+            return findDocumentQuadLines(img, q); } });
+        v.push_back({ "cascade", [](const Mat& img, vector<Point2f>& q) {
+            Detection d = detectCascade(img);
+            q = d.quad;
+            return d.found; } });
+        return v;
+    }
+
+    // Ground truth file: { "images": [ { "file": "...", "quad": [x0,y0,...,x3,y3] }, ... ] }
+    // Relative file names are resolved against the directory of the ground-truth file.
+    bool loadGroundTruth(const string& path, vector<LabelledImage>& out) {
+        FileStorage fs(path, FileStorage::READ);
+        if (!fs.isOpened()) return false;
+        size_t slash = path.find_last_of("/\\");
+        string dir = slash == string::npos ? "" : path.substr(0, slash + 1);
+        FileNode images = fs["images"];
+        for (FileNodeIterator it = images.begin(); it != images.end(); ++it) {
+            LabelledImage li;
+            string file = (string)(*it)["file"];
+            vector<float> coords;
+            (*it)["quad"] >> coords;
+            if (file.empty() || coords.size() != 8) continue;
+            bool absolute = file[0] == '/' || file[0] == '\\' || (file.size() > 1 && file[1] == ':');
+            li.file = absolute ? file : dir + file;
+            for (int i = 0; i < 4; ++i) li.quad.push_back(Point2f(coords[2 * i], coords[2 * i + 1]));
+            out.push_back(li);
+        }
+        return true;
+    }
+
+    double quadIoU(const vector<Point2f>& a, const vector<Point2f>& b) {
+        vector<Point2f> ha, hb, inter;
+        convexHull(a, ha);
+        convexHull(b, hb);
+        double ia = intersectConvexConvex(ha, hb, inter, true);
+        double ua = contourArea(ha) + contourArea(hb) - ia;
+        return ua > 0 ? ia / ua : 0.0;
+    }
+
+    // Mean corner distance after putting both quads in TL, TR, BR, BL order.
+    double meanCornerError(const vector<Point2f>& found, const vector<Point2f>& truth) {
+        vector<Point2f> f = reorderPoints(found), t = reorderPoints(truth);
+        double sum = 0;
+        for (int i = 0; i < 4; ++i) sum += norm(f[i] - t[i]);
+        return sum / 4.0;
+    }
+
+    // A detection counts as a hit when its IoU with the ground truth reaches hitIoU.
+    vector<AccuracyRow> evaluateDetectors(const vector<LabelledImage>& set,
+        const vector<DetectorVariant>& variants, double hitIoU = 0.9) {
+        vector<AccuracyRow> rows;
+        vector<Mat> images;
+        for (auto& li : set) images.push_back(imread(li.file, IMREAD_COLOR));
+
+        for (auto& v : variants) {
+            AccuracyRow row;
+            row.variant = v.name;
+            for (size_t i = 0; i < set.size(); ++i) {
+                if (images[i].empty()) {
+                    cerr << "Cannot open " << set[i].file << endl;
+                    continue;
+                }
+                ++row.images;
+                vector<Point2f> quad;
+                auto t0 = chrono::steady_clock::now();
+                bool found = v.detect(images[i], quad);
+                row.meanMs += chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+                if (!found || quad.size() != 4) continue;
+
+                ++row.detected;
+                double err = meanCornerError(quad, set[i].quad);
+                double diag = norm(set[i].quad[2] - set[i].quad[0]);
+                double iou = quadIoU(quad, set[i].quad);
+                row.meanCornerErrPx += err;
+                row.meanCornerErrPct += diag > 0 ? 100.0 * err / diag : 0;
+                row.meanIoU += iou;
+                if (iou >= hitIoU) ++row.hits;
+            }
+            if (row.images) row.meanMs /= row.images;
+            if (row.detected) {
+                row.meanCornerErrPx /= row.detected;
+                row.meanCornerErrPct /= row.detected;
+                row.meanIoU /= row.detected;
+            }
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    void printAccuracyTable(const vector<AccuracyRow>& rows) {
+        cout << left << setw(20) << "variant" << right << setw(8) << "images" << setw(10) << "detect%"
+            << setw(8) << "hit%" << setw(12) << "corner px" << setw(12) << "corner %" << setw(8) << "IoU"
+            << setw(10) << "ms/img" << endl;
+        for (auto& r : rows) {
+            double n = max(1, r.images);
+            cout << left << setw(20) << r.variant << right << setw(8) << r.images << fixed << setprecision(1)
+                << setw(10) << 100.0 * r.detected / n << setw(8) << 100.0 * r.hits / n
+                << setw(12) << r.meanCornerErrPx << setw(12) << setprecision(2) << r.meanCornerErrPct
+                << setw(8) << setprecision(3) << r.meanIoU << setw(10) << setprecision(2) << r.meanMs << endl;
+        }
+    }
+
+} // namespace DocScanner
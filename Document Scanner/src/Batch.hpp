@@ -0,0 +1,552 @@
+// Batch.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "Core.hpp"
+#include "Detection.hpp"
+#include "MultiDoc.hpp"
+#include "RemapCache.hpp"
+#include "Enhance.hpp"
+#include "Trace.hpp"
+#include "MemTrack.hpp"
+#include "PoolAllocator.hpp"
+#include "ResultCache.hpp"
+#include "Dedupe.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    struct BatchOptions {
+        bool enabled = false;     // --batch given: run headless instead of the GUI
+        vector<string> inputs;    // files or directories
+        string outDir = ".";
+        int workers = 0;          // 0 = hardware concurrency
+        string tracePath;         // --trace: Chrome trace JSON written on exit
+        bool memTrack = false;    // --memtrack: per-stage peak bytes in the manifest
+        bool pool = false;        // --pool: per-worker recycling of large Mat buffers
+        string liveSource;        // --live: GUI starts scanning this camera index / video
+        DetectorMethod detector = DetectorMethod::Contour; // --detector contour|lines|cascade
+        bool multi = false;       // --multi: every document in an image becomes its own page
+        BinarizeMethod binarize = BinarizeMethod::Adaptive; // --binarize adaptive|normalized
+        EnhanceMode enhance = EnhanceMode::None;            // --enhance magic|gray: extra _enhanced.png
+        bool rig = false;         // --rig: fixed camera, reuse cached warp maps across pages
+        string calibPath;         // --calib: lens calibration fused into the warp maps (implies --rig)
+        string cacheDir;          // --cache-dir: persistent caches; none unless given
+        bool resultCache = false; // --result-cache: reuse the quads of files processed before
+        bool cacheOutputs = false; // --cache-outputs: also reuse their encoded outputs (implies --result-cache)
+        DedupeMode dedupe = DedupeMode::Off; // --dedupe flag|skip: pages already seen earlier in the run
+        int dedupeDistance = 32;  // --dedupe-distance: most differing hash bits (of 256) for a duplicate
+    };
+
+    struct DocumentOutput {
+        vector<Point2f> quad;
+        string bwPath, colorPath, enhancedPath;
+    };
+
+    struct PageResult {
+        string input;
+        bool ok = false;          // decoded and processed
+        bool foundAuto = false;
+        double confidence = 0;    // of the detected quad; 0 when the full image was used
+        string detectorUsed;
+        vector<Point2f> quad;
+        string bwPath, colorPath, enhancedPath;
+        string cached;            // "quad" or "outputs" when served from the result cache
+        string duplicateOf;       // --dedupe: earlier input showing the same page
+        int duplicateDistance = -1; // differing hash bits to it
+        bool pageHashCached = false; // --dedupe: the page hash was read back from the result cache
+        bool cacheStoreFailed = false; // its result cache entry could not be written
+        double totalMs = 0;
+        map<string, long long> stagePeakBytes; // rise above stage entry, with --memtrack
+        vector<DocumentOutput> documents;      // --multi only; quad/bwPath/colorPath mirror the first
+    };
+
+    static void printBatchUsage() {
+        cout << "Usage: \"Document Scanner\" [image] [--live <camera index|video file>] [--cache-dir dir]\n"
+            "       \"Document Scanner\" --batch <file|dir>... [--out dir] [--workers N] [--trace trace.json] [--memtrack] [--multi]\n"
+            "                                  [--rig] [--calib camera.yml] [--binarize adaptive|normalized]\n"
+            "                                  [--enhance magic|gray] [--result-cache] [--cache-outputs]\n"
+            "                                  [--dedupe flag|skip] [--dedupe-distance bits]\n"
+            "  --detector contour|lines|cascade  page detector (GUI and batch; default contour)\n"
+            "  --pool   recycle large image buffers per worker between pages (flat memory on long runs)\n"
+            "  --multi  split images holding several documents (cards, receipts) into one page each\n"
+            "  --binarize normalized  divide out the lighting, then one global threshold (faster, no shadow blotches)\n"
+            "  --enhance  also write <name>_enhanced.png: white-balanced, contrast-stretched colour or grey\n"
+            "  --rig    fixed capture rig: warp maps are computed once per quad and reused\n"
+            "  --calib  camera_matrix/distortion_coefficients file; undistortion is folded into the warp\n"
+            "  --cache-dir  keep folder listings, thumbnails and results there between runs (default: nothing kept)\n"
+            "  --result-cache  files processed before (same bytes, same detector) skip detection\n"
+            "  --cache-outputs  ... and, with the same output settings, warping and encoding: outputs are copied\n"
+            "  --dedupe  mark (flag) or do not write (skip) pages that look like a page seen earlier in the run\n"
+            "  --dedupe-distance  most perceptual hash bits, of 256, two shots of one page may differ in (default 32)\n"
+            "  --trace also works in GUI mode; the trace is written when the window closes." << endl;
+    }
+
+    // Parses the command line. Positional arguments are images (GUI: the first is opened).
+    bool parseCommandLine(int argc, char** argv, BatchOptions& o) {
+        for (int i = 1; i < argc; ++i) {
+            string a = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (a == "--help" || a == "-h") return false;
+            else if (a == "--batch") o.enabled = true;
+            else if (a == "--out" && hasValue) o.outDir = argv[++i];
+            else if (a == "--workers" && hasValue) o.workers = max(0, atoi(argv[++i]));
+            else if (a == "--trace" && hasValue) o.tracePath = argv[++i];
+            else if (a == "--memtrack") o.memTrack = true;
+            else if (a == "--pool") o.pool = true;
+            else if (a == "--multi") o.multi = true;
+            else if (a == "--rig") o.rig = true;
+            else if (a == "--cache-dir" && hasValue) o.cacheDir = argv[++i];
+            else if (a == "--result-cache") o.resultCache = true;
+            else if (a == "--cache-outputs") o.resultCache = o.cacheOutputs = true;
+            else if (a == "--dedupe-distance" && hasValue) o.dedupeDistance = max(0, atoi(argv[++i]));
+            else if (a == "--dedupe" && hasValue) {
+                if (!parseDedupeName(argv[++i], o.dedupe)) {
+                    cerr << "Unknown dedupe mode: " << argv[i] << endl;
+                    return false;
+                }
+            }
+            else if (a == "--enhance" && hasValue) {
+                if (!parseEnhanceName(argv[++i], o.enhance)) {
+                    cerr << "Unknown enhance mode: " << argv[i] << endl;
+                    return false;
+                }
+            }
+            else if (a == "--binarize" && hasValue) {
+                string m = argv[++i];
+                if (m == "adaptive") o.binarize = BinarizeMethod::Adaptive;
+                else if (m == "normalized") o.binarize = BinarizeMethod::Normalized;
+                else {
+                    cerr << "Unknown binarization: " << m << endl;
+                    return false;
+                }
+            }
+            else if (a == "--calib" && hasValue) {
+                o.calibPath = argv[++i];
+                o.rig = true;
+            }
+            else if (a == "--live" && hasValue) o.liveSource = argv[++i];
+            else if (a == "--detector" && hasValue) {
+                if (!parseDetectorName(argv[++i], o.detector)) {
+                    cerr << "Unknown detector: " << argv[i] << endl;
+                    return false;
+                }
+            }
+            else if (a.size() > 1 && a[0] == '-' && a[1] == '-') {
+                cerr << "Unknown or incomplete argument: " << a << endl;
+                return false;
+            }
+            else o.inputs.push_back(a);
+        }
+        return true;
+    }
+
+    static bool isImagePath(const string& p) {
+        size_t dot = p.find_last_of('.');
+        if (dot == string::npos) return false;
+        string ext = p.substr(dot);
+        for (auto& ch : ext) ch = (char)tolower((unsigned char)ch);
+        return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tif" || ext == ".tiff";
+    }
+
+    static string stemOf(const string& path) {
+        size_t slash = path.find_last_of("/\\");
+        string name = slash == string::npos ? path : path.substr(slash + 1);
+        size_t dot = name.find_last_of('.');
+        return dot == string::npos ? name : name.substr(0, dot);
+    }
+
+    // Expands directories (non-recursive) into the image files they contain.
+    vector<string> expandInputs(const vector<string>& inputs) {
+        vector<string> files;
+        for (const string& in : inputs) {
+            if (isImagePath(in)) {
+                files.push_back(in);
+                continue;
+            }
+            vector<String> found;
+            try {
+                glob(in, found, false);
+            }
+            catch (const cv::Exception&) {
+                cerr << "Cannot list " << in << endl;
+            }
+            for (auto& f : found)
+                if (isImagePath(f)) files.push_back(f);
+        }
+        return files;
+    }
+
+    static vector<Point2f> fullFrame(const Mat& img) {
+        float w = (float)img.cols, h = (float)img.rows;
+        return { Point2f(0, 0), Point2f(w - 1, 0), Point2f(w - 1, h - 1), Point2f(0, h - 1) };
+    }
+
+    // What the quads depend on, and what the outputs depend on beyond the quads:
+    // the two halves of a result cache key.
+    string detectionSettings(DetectorMethod detector, bool multi) {
+        return multi ? string("multi") : string("detector=") + detectorName(detector);
+    }
+
+    static string outputSettings(const BatchOptions& opt) {
+        // --rig warps through fixed-point remap tables, which can differ from warpPerspective by a level
+        string s = "binarize=" + to_string((int)opt.binarize) + "|enhance=" + to_string((int)opt.enhance)
+            + "|rig=" + to_string((int)opt.rig) + "|multi=" + to_string((int)opt.multi);
+        vector<uchar> calib;
+        if (!opt.calibPath.empty() && readFileBytes(opt.calibPath, calib))
+            s += "|calib=" + to_string(hashBytes(calib.data(), calib.size()));
+        return s;
+    }
+
+    // Output file suffixes, <stem>_<suffix>, for a page of docCount documents.
+    static vector<string> outputSuffixes(const BatchOptions& opt, size_t docCount) {
+        vector<string> s;
+        for (size_t i = 0; i < docCount; ++i) {
+            string prefix = opt.multi ? to_string(i + 1) + "_" : string();
+            s.push_back(prefix + "bw.png");
+            s.push_back(prefix + "color.png");
+            if (opt.enhance != EnhanceMode::None) s.push_back(prefix + "enhanced.png");
+        }
+        return s;
+    }
+
+    // Fills the output paths of r as processPage would have written them.
+    static void setOutputPaths(const string& stem, const BatchOptions& opt, const vector<vector<Point2f>>& quads, PageResult& r) {
+        if (!opt.multi) {
+            r.bwPath = stem + "_bw.png";
+            r.colorPath = stem + "_color.png";
+            if (opt.enhance != EnhanceMode::None) r.enhancedPath = stem + "_enhanced.png";
+            return;
+        }
+        r.documents.clear();
+        for (size_t i = 0; i < quads.size(); ++i) {
+            DocumentOutput d;
+            d.quad = quads[i];
+            d.bwPath = stem + "_" + to_string(i + 1) + "_bw.png";
+            d.colorPath = stem + "_" + to_string(i + 1) + "_color.png";
+            if (opt.enhance != EnhanceMode::None) d.enhancedPath = stem + "_" + to_string(i + 1) + "_enhanced.png";
+            r.documents.push_back(d);
+        }
+        r.bwPath = r.documents[0].bwPath;
+        r.colorPath = r.documents[0].colorPath;
+        r.enhancedPath = r.documents[0].enhancedPath;
+    }
+
+    // Writes <stem>_<n>_bw.png / _color.png per document; returns false on an encode error.
+    static bool writeDocuments(const Mat& img, const vector<vector<Point2f>>& quads, const string& stem,
+        const BatchOptions& opt, PageResult& r) {
+        vector<ScannedDoc> docs = scanDocuments(img, quads, opt.binarize);
+        setOutputPaths(stem, opt, quads, r);
+
+        DS_PROFILE_SCOPE("encode");
+        try {
+            for (size_t i = 0; i < docs.size(); ++i) {
+                DocumentOutput& d = r.documents[i];
+                d.quad = docs[i].quad;
+                imwrite(d.bwPath, docs[i].bw);
+                imwrite(d.colorPath, docs[i].color);
+                if (!d.enhancedPath.empty()) imwrite(d.enhancedPath, enhance(docs[i].color, opt.enhance));
+            }
+        }
+        catch (const cv::Exception& e) {
+            cerr << "Failed to save " << stem << ": " << e.what() << endl;
+            return false;
+        }
+        r.quad = r.documents[0].quad;
+        return true;
+    }
+
+    // With --dedupe: looks the page up among the inputs before it and records
+    // in r which one it repeats, if any. True if it is not to be written.
+    static bool checkDuplicate(DedupeTurn& turn, const PageHash& h, const BatchOptions& opt, PageResult& r) {
+        r.duplicateOf = turn.findOrAdd(h, r.input, &r.duplicateDistance);
+        return !r.duplicateOf.empty() && opt.dedupe == DedupeMode::Skip;
+    }
+
+    // warpCache: shared map cache in --rig mode, else null. cache: with
+    // --result-cache, else null. dedupe: with --dedupe (single documents only), else
+    // null; order is then the page's input index, and pages must be started in it.
+    PageResult processPage(const string& path, const BatchOptions& opt, WarpMapCache* warpCache = nullptr,
+        ResultCache* cache = nullptr, DuplicateIndex* dedupe = nullptr, size_t order = 0) {
+        DS_PROFILE_SCOPE("page");
+        DedupeTurn turn(dedupe, order);
+        PageResult r;
+        r.input = path;
+        auto t0 = chrono::steady_clock::now();
+        string stem = opt.outDir + "/" + stemOf(path);
+
+        // With the result cache the file is read once, hashed, and decoded from memory
+        Mat img;
+        string cacheKey, outSettings = cache && opt.cacheOutputs ? outputSettings(opt) : string();
+        ResultCache::Entry cached;
+        bool hit = false, deduped = false;
+        if (cache) {
+            vector<uchar> bytes;
+            {
+                DS_PROFILE_SCOPE("readFile");
+                readFileBytes(path, bytes);
+            }
+            if (!bytes.empty()) {
+                cacheKey = cache->key(bytes, detectionSettings(opt.detector, opt.multi));
+                hit = cache->find(cacheKey, cached) && !cached.quads.empty();
+                if (hit) {
+                    r.foundAuto = cached.foundAuto;
+                    r.confidence = cached.confidence;
+                    if (cached.foundAuto) r.detectorUsed = cached.detector;
+                }
+                // A known page hash settles a skipped duplicate without decoding
+                PageHash known;
+                if (hit && dedupe && PageHash::fromHex(cached.pageHash, known)) {
+                    deduped = r.pageHashCached = true;
+                    if (checkDuplicate(turn, known, opt, r)) {
+                        r.quad = cached.quads[0];
+                        r.cached = "quad";
+                        r.ok = true;
+                        r.totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+                        return r;
+                    }
+                }
+                if (hit && opt.cacheOutputs && (!dedupe || deduped)) {
+                    vector<pair<string, string>> files;
+                    for (auto& s : outputSuffixes(opt, cached.quads.size())) files.push_back({ s, stem + "_" + s });
+                    if (cache->fetchOutputs(cacheKey, outSettings, files)) {
+                        setOutputPaths(stem, opt, cached.quads, r);
+                        r.quad = cached.quads[0];
+                        r.cached = "outputs";
+                        r.ok = true;
+                        r.totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+                        return r;
+                    }
+                }
+                DS_PROFILE_SCOPE("decode");
+                img = imdecode(bytes, IMREAD_COLOR);
+            }
+        }
+        else {
+            DS_PROFILE_SCOPE("decode");
+            img = imread(path, IMREAD_COLOR);
+        }
+        if (img.empty()) {
+            cerr << "Cannot open " << path << endl;
+            return r;
+        }
+
+        vector<vector<Point2f>> quads;
+        if (hit) {
+            quads = cached.quads;
+            r.cached = "quad";
+        }
+        else if (opt.multi) {
+            quads = findDocuments(img);
+            r.foundAuto = !quads.empty();
+            if (quads.empty()) quads.push_back(fullFrame(img));
+        }
+        else {
+            Detection d = detect(img, opt.detector);
+            r.foundAuto = d.found;
+            r.confidence = d.confidence;
+            if (d.found) r.detectorUsed = d.detector;
+            quads.push_back(reorderPoints(d.found ? d.quad : fullFrame(img)));
+        }
+        Mat warped;
+        if (!opt.multi) {
+            r.quad = quads[0];
+            warped = warpCache ? getWarpedA4Cached(*warpCache, img, r.quad) : getWarpedA4(img, r.quad);
+        }
+        bool skip = false;
+        string hashHex = cached.pageHash;
+        if (dedupe && !opt.multi && !deduped) {
+            PageHash h = pageHash(warped);
+            hashHex = h.hex();
+            skip = checkDuplicate(turn, h, opt, r);
+        }
+        // New files, and cached ones that just got their page hash
+        if (!cacheKey.empty() && (!hit || hashHex != cached.pageHash)) {
+            ResultCache::Entry e;
+            e.foundAuto = r.foundAuto;
+            e.confidence = r.confidence;
+            e.detector = r.detectorUsed;
+            e.quads = quads;
+            e.pageHash = hashHex;
+            r.cacheStoreFailed = !cache->store(cacheKey, e);
+        }
+
+        if (skip) r.ok = true;
+        else if (opt.multi) r.ok = writeDocuments(img, quads, stem, opt, r);
+        else {
+            Mat bw = binarize(warped, opt.binarize);
+            Mat enhanced = enhance(warped, opt.enhance);
+            setOutputPaths(stem, opt, quads, r);
+            DS_PROFILE_SCOPE("encode");
+            try {
+                imwrite(r.bwPath, bw);
+                imwrite(r.colorPath, warped);
+                if (!enhanced.empty()) imwrite(r.enhancedPath, enhanced);
+                r.ok = true;
+            }
+            catch (const cv::Exception& e) {
+                cerr << "Failed to save " << stem << ": " << e.what() << endl;
+            }
+        }
+        if (r.ok && !skip && !cacheKey.empty() && opt.cacheOutputs) {
+            for (auto& s : outputSuffixes(opt, quads.size())) cache->storeOutput(cacheKey, outSettings, s, stem + "_" + s);
+        }
+        r.totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        return r;
+    }
+
+    // pool: combined buffer pool statistics with --pool, else null.
+    void writeManifest(const string& path, const vector<PageResult>& pages, DetectorMethod detector,
+        const BufferPool::Stats* pool = nullptr) {
+        FileStorage fs(path, FileStorage::WRITE | FileStorage::FORMAT_JSON);
+        if (!fs.isOpened()) {
+            cerr << "Cannot write " << path << endl;
+            return;
+        }
+        fs << "detector" << detectorName(detector);
+        if (pool) {
+            fs << "pool" << "{" << "requests" << (double)pool->requests << "reused" << (double)pool->reused
+                << "reuse_rate" << pool->reuseRate() << "cached_bytes" << (double)pool->cachedBytes << "}";
+        }
+        if (MemTracker::enabled())
+            fs << "process_peak_bytes" << (double)MemTracker::instance().peakBytes();
+        fs << "pages" << "[";
+        for (auto& p : pages) {
+            fs << "{";
+            fs << "input" << p.input;
+            fs << "ok" << (int)p.ok;
+            fs << "found_auto" << (int)p.foundAuto;
+            fs << "confidence" << p.confidence;
+            if (!p.detectorUsed.empty()) fs << "detector_used" << p.detectorUsed;
+            fs << "quad" << p.quad;
+            fs << "bw" << p.bwPath;
+            fs << "color" << p.colorPath;
+            if (!p.enhancedPath.empty()) fs << "enhanced" << p.enhancedPath;
+            if (!p.cached.empty()) fs << "cached" << p.cached;
+            if (!p.duplicateOf.empty()) fs << "duplicate_of" << p.duplicateOf << "duplicate_distance" << p.duplicateDistance;
+            fs << "total_ms" << p.totalMs;
+            if (!p.documents.empty()) {
+                fs << "documents" << "[";
+                for (auto& d : p.documents) {
+                    fs << "{" << "quad" << d.quad << "bw" << d.bwPath << "color" << d.colorPath;
+                    if (!d.enhancedPath.empty()) fs << "enhanced" << d.enhancedPath;
+                    fs << "}";
+                }
+                fs << "]";
+            }
+            if (!p.stagePeakBytes.empty()) {
+                auto page = p.stagePeakBytes.find("page");
+                if (page != p.stagePeakBytes.end()) fs << "peak_bytes" << (double)page->second;
+                fs << "stage_peak_bytes" << "{";
+                for (auto& kv : p.stagePeakBytes) fs << kv.first << (double)kv.second;
+                fs << "}";
+            }
+            fs << "}";
+        }
+        fs << "]";
+    }
+
+    // Processes every input on a pool of worker threads and writes
+    // <outDir>/manifest.json. Returns the process exit code.
+    int runBatch(const BatchOptions& opt) {
+        vector<string> files = expandInputs(opt.inputs);
+        if (files.empty()) {
+            cerr << "No input images." << endl;
+            return 1;
+        }
+
+        // Pool first, so memory tracking wraps it and still sees every Mat
+        if (opt.pool) PoolAllocator::instance().install();
+        if (opt.memTrack) MemTracker::instance().setEnabled(true);
+        vector<BufferPool*> pools;
+        WarpMapCache warpCache;
+        if (!opt.calibPath.empty()) {
+            LensCalibration lens;
+            if (!loadCalibration(opt.calibPath, lens)) {
+                cerr << "Cannot read calibration " << opt.calibPath << endl;
+                return 1;
+            }
+            warpCache.setLens(lens);
+        }
+        ResultCache resultCache;
+        if (opt.resultCache && !resultCache.open(opt.cacheDir.empty() ? string() : opt.cacheDir + "/results"))
+            cerr << "Result cache disabled: no usable --cache-dir" << endl;
+        unique_ptr<DuplicateIndex> dedupe;
+        if (opt.dedupe != DedupeMode::Off) {
+            if (opt.multi) cerr << "--dedupe is ignored with --multi" << endl;
+            else dedupe.reset(new DuplicateIndex(opt.dedupeDistance));
+        }
+        int workers = opt.workers > 0 ? opt.workers : (int)max(1u, thread::hardware_concurrency());
+        workers = min(workers, (int)files.size());
+        vector<PageResult> results(files.size());
+        atomic<size_t> next(0);
+        for (int w = 0; w < workers && opt.pool; ++w) pools.push_back(PoolAllocator::instance().createPool());
+
+        auto worker = [&](int id) {
+            if (Tracer::enabled()) Tracer::instance().setThreadName("worker " + to_string(id));
+            BufferPool* pool = opt.pool ? pools[id] : nullptr;
+            ScopedBufferPool bindPool(pool);
+            for (size_t i = next++; i < files.size(); i = next++) {
+                ScopedTraceTag tag(files[i]);
+                if (opt.memTrack) MemTracker::instance().beginPage();
+                results[i] = processPage(files[i], opt, opt.rig ? &warpCache : nullptr,
+                    resultCache.enabled() ? &resultCache : nullptr, dedupe.get(), i);
+                if (opt.memTrack) results[i].stagePeakBytes = MemTracker::instance().endPage();
+                if (pool) pool->endPage();
+                cout << string(results[i].ok ? "ok   " : "FAIL ") + files[i] + "\n";
+            }
+        };
+        vector<thread> pool;
+        for (int w = 0; w < workers; ++w) pool.emplace_back(worker, w);
+        for (auto& t : pool) t.join();
+
+        BufferPool::Stats poolStats;
+        for (auto* p : pools) {
+            BufferPool::Stats s = p->stats();
+            poolStats.requests += s.requests;
+            poolStats.reused += s.reused;
+            poolStats.cachedBytes += s.cachedBytes;
+            poolStats.outstandingBytes += s.outstandingBytes;
+        }
+        // --multi always uses contour search
+        writeManifest(opt.outDir + "/manifest.json", results, opt.multi ? DetectorMethod::Contour : opt.detector,
+            opt.pool ? &poolStats : nullptr);
+        int failed = 0;
+        for (auto& r : results) if (!r.ok) ++failed;
+        cout << files.size() - failed << "/" << files.size() << " pages processed." << endl;
+        if (resultCache.enabled()) {
+            cout << "Result cache: " << resultCache.hits() << " hits";
+            if (opt.cacheOutputs) cout << " (" << resultCache.outputHits() << " with outputs)";
+            cout << ", " << resultCache.misses() << " misses." << endl;
+            size_t storeFailures = 0;
+            for (auto& r : results) if (r.cacheStoreFailed) ++storeFailures;
+            if (storeFailures)
+                cerr << "Result cache: " << storeFailures << " entries could not be written to " << opt.cacheDir << "/results" << endl;
+        }
+        if (dedupe) {
+            cout << "Duplicates: " << dedupe->duplicates() << " of " << files.size() - failed << " pages "
+                << (opt.dedupe == DedupeMode::Skip ? "skipped" : "flagged");
+            if (resultCache.enabled()) {
+                size_t cachedHashes = 0;
+                for (auto& r : results) if (r.pageHashCached) ++cachedHashes;
+                cout << ", " << cachedHashes << " page hashes read from the result cache";
+            }
+            cout << "." << endl;
+        }
+        if (opt.rig)
+            cout << "Warp maps: " << warpCache.misses() << " built, " << warpCache.hits() << " reused." << endl;
+        if (opt.pool)
+            cout << "Buffer pool: " << poolStats.reused << "/" << poolStats.requests << " buffers reused ("
+                << (int)round(100 * poolStats.reuseRate()) << "%), " << poolStats.cachedBytes / 1048576 << " MB cached." << endl;
+        return failed ? 2 : 0;
+    }
+
+} // namespace DocScanner
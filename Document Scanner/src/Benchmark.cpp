@@ -0,0 +1,296 @@
+// Benchmark.cpp
+// Standalone timing of the DocScanner stages over a range of input sizes and
+// OpenCV thread counts, plus the detection accuracy harness ("accuracy" mode)
+// and the synthetic document generator ("synth" mode).
+// Results are written as JSON so runs from different releases can be compared.
+#include <opencv2/opencv.hpp>
+#include "Core.hpp"
+#include "LineDetector.hpp"
+#include "Accuracy.hpp"
+#include "RemapCache.hpp"
+#include "Enhance.hpp"
+#include "Synthetic.hpp"
+#include "ResultCache.hpp"
+#include "Dedupe.hpp"
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+using namespace DocScanner;
+
+struct BenchOptions {
+    vector<string> images = { "resources/paper.jpg", "resources/document.png", "resources/cards.jpg" };
+    vector<double> megapixels = { 1, 4, 16, 50, 100 };
+    vector<int> threads = { 1, 0 }; // 0 = OpenCV default (all cores)
+    int reps = 5;
+    string out = "benchmark.json";
+};
+
+struct Timing {
+    double minMs = 0, medianMs = 0, meanMs = 0;
+};
+
+static vector<string> splitList(const string& s) {
+    vector<string> out;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, ','))
+        if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+static void printUsage() {
+    cout << "Usage: Benchmark [--images a.jpg,b.png] [--mp 1,4,16,50,100]\n"
+        "                 [--threads 1,0] [--reps 5] [--out benchmark.json]\n"
+        "       Benchmark accuracy [--gt resources/groundtruth.json] [--hit-iou 0.9] [--out accuracy.json]\n"
+        "       Benchmark synth --out dir [--count 50] [--mp 4] [--seed 1]\n"
+        "  --threads 0 means OpenCV's default thread count.\n"
+        "  The image name 'synthetic' renders a synthetic page at each size instead of upscaling." << endl;
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions& o) {
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--help" || a == "-h") return false;
+        else if (a == "--images" && hasValue) o.images = splitList(argv[++i]);
+        else if (a == "--mp" && hasValue) {
+            o.megapixels.clear();
+            for (auto& v : splitList(argv[++i])) o.megapixels.push_back(atof(v.c_str()));
+        }
+        else if (a == "--threads" && hasValue) {
+            o.threads.clear();
+            for (auto& v : splitList(argv[++i])) o.threads.push_back(atoi(v.c_str()));
+        }
+        else if (a == "--reps" && hasValue) o.reps = max(1, atoi(argv[++i]));
+        else if (a == "--out" && hasValue) o.out = argv[++i];
+        else {
+            cerr << "Unknown or incomplete argument: " << a << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs fn reps times; callsPerRep > 1 divides each sample for very cheap functions.
+static Timing timeIt(int reps, int callsPerRep, const function<void()>& fn) {
+    vector<double> samples;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = chrono::steady_clock::now();
+        for (int c = 0; c < callsPerRep; ++c) fn();
+        auto t1 = chrono::steady_clock::now();
+        samples.push_back(chrono::duration<double, milli>(t1 - t0).count() / callsPerRep);
+    }
+    sort(samples.begin(), samples.end());
+    Timing t;
+    t.minMs = samples.front();
+    t.medianMs = samples[samples.size() / 2];
+    double sum = 0;
+    for (double v : samples) sum += v;
+    t.meanMs = sum / samples.size();
+    return t;
+}
+
+static Mat scaleToMegapixels(const Mat& img, double mp) {
+    double s = sqrt(mp * 1e6 / ((double)img.cols * img.rows));
+    Size sz(max(1, (int)round(img.cols * s)), max(1, (int)round(img.rows * s)));
+    Mat out;
+    resize(img, out, sz, 0, 0, s < 1.0 ? INTER_AREA : INTER_LINEAR);
+    return out;
+}
+
+static string baseName(const string& path) {
+    size_t p = path.find_last_of("/\\");
+    return p == string::npos ? path : path.substr(p + 1);
+}
+
+// Compares detector variants against labelled corners: detection rate, corner
+// error, quad IoU and time per image in one table.
+static int runAccuracy(int argc, char** argv) {
+    string gtPath = "resources/groundtruth.json", out;
+    double hitIoU = 0.9;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--gt" && hasValue) gtPath = argv[++i];
+        else if (a == "--hit-iou" && hasValue) hitIoU = atof(argv[++i]);
+        else if (a == "--out" && hasValue) out = argv[++i];
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    vector<LabelledImage> set;
+    if (!loadGroundTruth(gtPath, set) || set.empty()) {
+        cerr << "Cannot read ground truth " << gtPath << endl;
+        return 1;
+    }
+    vector<AccuracyRow> rows = evaluateDetectors(set, defaultDetectorVariants(), hitIoU);
+    printAccuracyTable(rows);
+
+    if (!out.empty()) {
+        FileStorage fs(out, FileStorage::WRITE | FileStorage::FORMAT_JSON);
+        if (!fs.isOpened()) {
+            cerr << "Cannot write " << out << endl;
+            return 1;
+        }
+        fs << "ground_truth" << gtPath << "hit_iou" << hitIoU;
+        fs << "results" << "[";
+        for (auto& r : rows) {
+            fs << "{" << "variant" << r.variant << "images" << r.images << "detected" << r.detected
+                << "hits" << r.hits << "corner_err_px" << r.meanCornerErrPx << "corner_err_pct" << r.meanCornerErrPct
+                << "iou" << r.meanIoU << "ms_per_image" << r.meanMs << "}";
+        }
+        fs << "]";
+    }
+    return 0;
+}
+
+// Writes a labelled synthetic set that "accuracy --gt <dir>/groundtruth.json" can consume.
+static int runSynth(int argc, char** argv) {
+    string out;
+    int count = 50;
+    uint64 seed = 1;
+    SyntheticParams p;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--out" && hasValue) out = argv[++i];
+        else if (a == "--count" && hasValue) count = max(1, atoi(argv[++i]));
+        else if (a == "--mp" && hasValue) p.megapixels = atof(argv[++i]);
+        else if (a == "--seed" && hasValue) seed = (uint64)atoll(argv[++i]);
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (out.empty()) {
+        printUsage();
+        return 1;
+    }
+    if (!writeSyntheticSet(out, count, p, seed)) {
+        cerr << "Cannot write synthetic set to " << out << endl;
+        return 1;
+    }
+    cout << "Wrote " << count << " documents and groundtruth.json to " << out << endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "accuracy")
+        return runAccuracy(argc - 1, argv + 1);
+    if (argc > 1 && string(argv[1]) == "synth")
+        return runSynth(argc - 1, argv + 1);
+
+    BenchOptions opt;
+    if (!parseArgs(argc, argv, opt)) {
+        printUsage();
+        return 1;
+    }
+
+    FileStorage fs(opt.out, FileStorage::WRITE | FileStorage::FORMAT_JSON);
+    if (!fs.isOpened()) {
+        cerr << "Cannot write " << opt.out << endl;
+        return 1;
+    }
+    fs << "opencv_version" << CV_VERSION;
+    fs << "cpus" << getNumberOfCPUs();
+    fs << "reps" << opt.reps;
+    fs << "results" << "[";
+
+    int defaultThreads = getNumThreads();
+    cout << left << setw(16) << "image" << setw(8) << "MP" << setw(8) << "threads"
+        << setw(30) << "function" << right << setw(12) << "median ms" << setw(12) << "min ms" << endl;
+
+    for (const string& path : opt.images) {
+        bool synthetic = path == "synthetic";
+        Mat src;
+        if (!synthetic) {
+            src = imread(path, IMREAD_COLOR);
+            if (src.empty()) {
+                cerr << "Cannot open " << path << ", skipping" << endl;
+                continue;
+            }
+        }
+        for (double mp : opt.megapixels) {
+            Mat img;
+            if (synthetic) {
+                SyntheticParams sp;
+                sp.megapixels = mp;
+                RNG rng(12345); // same page layout at every size
+                img = generateSyntheticDocument(sp, rng).image;
+            }
+            else img = scaleToMegapixels(src, mp);
+            double actualMp = (double)img.cols * img.rows / 1e6;
+
+            for (int th : opt.threads) {
+                setNumThreads(th > 0 ? th : defaultThreads);
+                int usedThreads = getNumThreads();
+
+                // Inputs for the later stages come from the earlier ones
+                Mat pre;
+                vector<Point2f> quad;
+                map<string, Timing> results;
+                results["preProcessForContours"] = timeIt(opt.reps, 1, [&]() { pre = preProcessForContours(img); });
+                results["findDocumentContour"] = timeIt(opt.reps, 1, [&]() { findDocumentContour(pre, quad); });
+                vector<Point2f> lineQuad;
+                results["findDocumentQuadLines"] = timeIt(opt.reps, 1, [&]() { findDocumentQuadLines(img, lineQuad); });
+                if (quad.size() != 4) {
+                    float w = (float)img.cols, h = (float)img.rows;
+                    quad = { Point2f(w * 0.1f, h * 0.1f), Point2f(w * 0.9f, h * 0.1f),
+                        Point2f(w * 0.9f, h * 0.9f), Point2f(w * 0.1f, h * 0.9f) };
+                }
+                vector<Point2f> ordered;
+                results["reorderPoints"] = timeIt(opt.reps, 1000, [&]() { ordered = reorderPoints(quad); });
+                Mat warped;
+                results["getWarpedA4"] = timeIt(opt.reps, 1, [&]() { warped = getWarpedA4(img, ordered); });
+                WarpMapCache warpCache;
+                getWarpedA4Cached(warpCache, img, ordered); // build the maps once, time the reuse
+                results["getWarpedA4Cached"] = timeIt(opt.reps, 1, [&]() { warped = getWarpedA4Cached(warpCache, img, ordered); });
+                Mat bw;
+                results["makeBWScanEffect"] = timeIt(opt.reps, 1, [&]() { bw = makeBWScanEffect(warped); });
+                results["makeBWNormalized"] = timeIt(opt.reps, 1, [&]() { bw = makeBWNormalized(warped); });
+                Mat enhanced;
+                results["makeMagicColor"] = timeIt(opt.reps, 10, [&]() { enhanced = makeMagicColor(warped); });
+                PageHash ph;
+                results["pageHash"] = timeIt(opt.reps, 100, [&]() { ph = pageHash(warped); });
+
+                // Result cache key of a JPEG input against the decode a hit saves
+                vector<uchar> jpeg;
+                imencode(".jpg", img, jpeg);
+                unsigned long long hash = 0;
+                results["hashBytes(jpeg)"] = timeIt(opt.reps, 10, [&]() { hash ^= hashBytes(jpeg.data(), jpeg.size()); });
+                results["imdecode(jpeg)"] = timeIt(opt.reps, 1, [&]() { imdecode(jpeg, IMREAD_COLOR); });
+                (void)hash;
+
+                for (auto& kv : results) {
+                    fs << "{";
+                    fs << "image" << baseName(path);
+                    fs << "megapixels" << actualMp;
+                    fs << "width" << img.cols;
+                    fs << "height" << img.rows;
+                    fs << "threads" << usedThreads;
+                    fs << "function" << kv.first;
+                    fs << "min_ms" << kv.second.minMs;
+                    fs << "median_ms" << kv.second.medianMs;
+                    fs << "mean_ms" << kv.second.meanMs;
+                    fs << "}";
+
+                    cout << left << setw(16) << baseName(path) << setw(8) << fixed << setprecision(1) << actualMp
+                        << setw(8) << usedThreads << setw(30) << kv.first << right << setw(12) << setprecision(3)
+                        << kv.second.medianMs << setw(12) << kv.second.minMs << endl;
+                }
+            }
+        }
+    }
+    fs << "]";
+    fs.release();
+    setNumThreads(defaultThreads);
+    cout << "Wrote " << opt.out << endl;
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include "Profiler.hpp"
 
 using namespace cv;
 using namespace std;
@@ -17,6 +18,7 @@ namespace DocScanner {
 
     vector<Point2f> reorderPoints(const vector<Point2f>& pts) {
         if (pts.size() != 4) return pts;
+        DS_PROFILE_SCOPE("reorderPoints");
         vector<Point2f> sorted = pts;
         sort(sorted.begin(), sorted.end(), [](const Point2f& a, const Point2f& b) { return a.x < b.x; });
         vector<Point2f> left = { sorted[0], sorted[1] };
@@ -26,33 +28,61 @@ namespace DocScanner {
         return { left[0], right[0], right[1], left[1] };
     }
 
+    // Median of an 8-bit image from its histogram: one pass, no copy of the pixels.
+    static int medianU8(const Mat& img) {
+        int hist[256] = { 0 };
+        for (int y = 0; y < img.rows; ++y) {
+            const uchar* row = img.ptr<uchar>(y);
+            for (int x = 0; x < img.cols; ++x) ++hist[row[x]];
+        }
+        long long half = (long long)img.total() / 2, acc = 0;
+        for (int v = 0; v < 256; ++v) {
+            acc += hist[v];
+            if (acc > half) return v;
+        }
+        return 128;
+    }
+
     Mat preProcessForContours(const Mat& img) {
+        DS_PROFILE_SCOPE("preProcessForContours");
         Mat gray, blurred, edges, closed;
         cvtColor(img, gray, COLOR_BGR2GRAY);
-        bilateralFilter(gray, blurred, 9, 75, 75);
-
-        Mat flat = blurred.reshape(0, 1);
-        flat.convertTo(flat, CV_8U);
-        vector<uchar> vals(flat.datastart, flat.dataend);
-        double med = 128;
-        if (!vals.empty()) {
-            nth_element(vals.begin(), vals.begin() + vals.size() / 2, vals.end());
-            med = vals[vals.size() / 2];
+        {
+            DS_PROFILE_SCOPE("bilateralFilter");
+            bilateralFilter(gray, blurred, 9, 75, 75);
+        }
+
+        double med;
+        {
+            DS_PROFILE_SCOPE("median");
+            med = medianU8(blurred);
         }
 
         double lower = max(0.0, (1.0 - 0.33) * med);
         double upper = min(255.0, (1.0 + 0.33) * med);
-        Canny(blurred, edges, lower, upper);
+        {
+            DS_PROFILE_SCOPE("Canny");
+            Canny(blurred, edges, lower, upper);
+        }
 
-        Mat kernel = getStructuringElement(MORPH_RECT, Size(5, 5));
-        morphologyEx(edges, closed, MORPH_CLOSE, kernel);
-        GaussianBlur(closed, closed, Size(3, 3), 0);
+        {
+            DS_PROFILE_SCOPE("morphClose");
+            static const Mat kernel = getStructuringElement(MORPH_RECT, Size(5, 5));
+            morphologyEx(edges, closed, MORPH_CLOSE, kernel);
+            GaussianBlur(closed, closed, Size(3, 3), 0);
+        }
         return closed;
     }
 
-    bool findDocumentContour(const Mat& pre, vector<Point2f>& outQuad) {
+    // approximate (optional) is set when no 4-corner contour was found and the
+    // quad is the minimum-area rectangle around the largest contour instead.
+    bool findDocumentContour(const Mat& pre, vector<Point2f>& outQuad, bool* approximate = nullptr) {
+        DS_PROFILE_SCOPE("findDocumentContour");
         vector<vector<Point>> contours;
-        findContours(pre, contours, RETR_LIST, CHAIN_APPROX_SIMPLE);
+        {
+            DS_PROFILE_SCOPE("findContours");
+            findContours(pre, contours, RETR_LIST, CHAIN_APPROX_SIMPLE);
+        }
         if (contours.empty()) return false;
 
         sort(contours.begin(), contours.end(), [](const vector<Point>& a, const vector<Point>& b) {
@@ -68,6 +98,7 @@ namespace DocScanner {
             if (approx.size() == 4 && isContourConvex(approx)) {
                 outQuad.clear();
                 for (auto& p : approx) outQuad.push_back(Point2f(p));
+                if (approximate) *approximate = false;
                 return true;
             }
         }
@@ -79,13 +110,56 @@ namespace DocScanner {
             RotatedRect r = minAreaRect(c);
             Point2f pts[4]; r.points(pts);
             outQuad.assign(pts, pts + 4);
+            if (approximate) *approximate = true;
             return true;
         }
         return false;
     }
 
+    // Every convex quad above minAreaRatio of the image that does not overlap a
+    // larger one already taken: several cards or receipts in one photo or scan.
+    vector<vector<Point2f>> findDocumentContours(const Mat& pre, double minAreaRatio = 0.01) {
+        DS_PROFILE_SCOPE("findDocumentContours");
+        vector<vector<Point>> contours;
+        {
+            DS_PROFILE_SCOPE("findContours");
+            findContours(pre, contours, RETR_LIST, CHAIN_APPROX_SIMPLE);
+        }
+        sort(contours.begin(), contours.end(), [](const vector<Point>& a, const vector<Point>& b) {
+            return contourArea(a, false) > contourArea(b, false);
+            });
+
+        double minArea = max(1000.0, minAreaRatio * pre.cols * pre.rows);
+        vector<vector<Point2f>> quads;
+        vector<double> areas;
+        for (const auto& c : contours) {
+            double area = contourArea(c);
+            if (area < minArea) break;
+            double peri = arcLength(c, true);
+            vector<Point> approx;
+            approxPolyDP(c, approx, 0.02 * peri, true);
+            if (approx.size() != 4 || !isContourConvex(approx)) continue;
+
+            vector<Point2f> q;
+            for (auto& p : approx) q.push_back(Point2f(p));
+            double qa = contourArea(q);
+            // The closed edge band yields an inner and an outer contour per page, and
+            // printed boxes sit inside pages: skip anything mostly covered already.
+            bool overlaps = false;
+            for (size_t i = 0; i < quads.size() && !overlaps; ++i) {
+                vector<Point2f> inter;
+                overlaps = intersectConvexConvex(quads[i], q, inter, true) > 0.2 * min(qa, areas[i]);
+            }
+            if (overlaps) continue;
+            quads.push_back(q);
+            areas.push_back(qa);
+        }
+        return quads;
+    }
+
     Mat getWarpedA4(const Mat& imgOrig, const vector<Point2f>& srcPts, int targetHeight = 842) {
         if (srcPts.size() != 4) return Mat();
+        DS_PROFILE_SCOPE("getWarpedA4");
         double aspect = 210.0 / 297.0;
         int h = targetHeight;
         int w = (int)round(h * aspect);
@@ -99,22 +173,79 @@ namespace DocScanner {
 
         Mat M = getPerspectiveTransform(srcPts, dst);
         Mat warped;
-        warpPerspective(imgOrig, warped, M, Size(w, h), INTER_LINEAR, BORDER_CONSTANT);
+        {
+            DS_PROFILE_SCOPE("warpPerspective");
+            warpPerspective(imgOrig, warped, M, Size(w, h), INTER_LINEAR, BORDER_CONSTANT);
+        }
         return warped;
     }
 
     Mat makeBWScanEffect(const Mat& warped) {
+        DS_PROFILE_SCOPE("makeBWScanEffect");
         Mat gray, clahe, bw;
         if (warped.channels() == 3)
             cvtColor(warped, gray, COLOR_BGR2GRAY);
         else
             gray = warped;
 
-        Ptr<CLAHE> c = createCLAHE(2.0, Size(8, 8));
-        c->apply(gray, clahe);
-        adaptiveThreshold(clahe, bw, 255,
-            ADAPTIVE_THRESH_GAUSSIAN_C, THRESH_BINARY, 15, 10);
+        {
+            DS_PROFILE_SCOPE("CLAHE");
+            Ptr<CLAHE> c = createCLAHE(2.0, Size(8, 8));
+            c->apply(gray, clahe);
+        }
+        {
+            DS_PROFILE_SCOPE("adaptiveThreshold");
+            adaptiveThreshold(clahe, bw, 255,
+                ADAPTIVE_THRESH_GAUSSIAN_C, THRESH_BINARY, 15, 10);
+        }
         return bw;
     }
 
+    // Paper brightness at every pixel. Estimated on a copy no larger than workSide,
+    // where a closing wipes out the (dark, thin) text and a median smooths what is
+    // left, then stretched back to full size.
+    Mat estimateIllumination(const Mat& gray, int workSide = 128) {
+        DS_PROFILE_SCOPE("estimateIllumination");
+        double s = min(1.0, (double)workSide / max(gray.cols, gray.rows));
+        Mat small, bg;
+        resize(gray, small, Size(), s, s, INTER_AREA);
+        morphologyEx(small, small, MORPH_CLOSE, getStructuringElement(MORPH_ELLIPSE, Size(7, 7)));
+        medianBlur(small, small, 5);
+        resize(small, bg, gray.size(), 0, 0, INTER_LINEAR);
+        return bg;
+    }
+
+    // Divides the illumination out so the paper is uniformly white: shadows and
+    // lighting gradients are gone before any thresholding.
+    Mat normalizeIllumination(const Mat& gray) {
+        DS_PROFILE_SCOPE("normalizeIllumination");
+        Mat bg = estimateIllumination(gray), out;
+        divide(gray, max(bg, 1), out, 255.0);
+        return out;
+    }
+
+    enum class BinarizeMethod { Adaptive, Normalized };
+
+    // Illumination normalization followed by one global Otsu threshold. The
+    // threshold is capped so a blank page does not turn its noise into speckles.
+    Mat makeBWNormalized(const Mat& warped) {
+        DS_PROFILE_SCOPE("makeBWNormalized");
+        Mat gray, bw;
+        if (warped.channels() == 3)
+            cvtColor(warped, gray, COLOR_BGR2GRAY);
+        else
+            gray = warped;
+        Mat flat = normalizeIllumination(gray);
+        {
+            DS_PROFILE_SCOPE("otsu");
+            double t = threshold(flat, bw, 0, 255, THRESH_BINARY | THRESH_OTSU);
+            if (t > 200) threshold(flat, bw, 200, 255, THRESH_BINARY);
+        }
+        return bw;
+    }
+
+    Mat binarize(const Mat& warped, BinarizeMethod m) {
+        return m == BinarizeMethod::Normalized ? makeBWNormalized(warped) : makeBWScanEffect(warped);
+    }
+
 } // namespace DocScanner
@@ -0,0 +1,196 @@
+// Dedupe.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/hal/hal.hpp>
+#include <opencv2/flann/lsh_table.h>
+#include "Profiler.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    enum class DedupeMode { Off, Flag, Skip };
+
+    bool parseDedupeName(const string& name, DedupeMode& m) {
+        if (name == "flag") m = DedupeMode::Flag;
+        else if (name == "skip") m = DedupeMode::Skip;
+        else if (name == "off") m = DedupeMode::Off;
+        else return false;
+        return true;
+    }
+
+    // 256-bit perceptual hash of a warped page: the signs of the lowest 16x16
+    // DCT frequencies of a 64x64 grey thumbnail, taken against their median
+    // (the DC term is left out). Two shots of the same page warp to nearly the
+    // same image, so their hashes differ in a few bits; different pages of the
+    // same layout still differ in the finer frequencies that place text lines.
+    struct PageHash {
+        static const int kBytes = 32;
+        unsigned long long bits[4] = { 0, 0, 0, 0 }; // 8-byte aligned, as cvflann's LSH reads it in words
+
+        const uchar* data() const { return (const uchar*)bits; }
+        int distance(const PageHash& o) const { return hal::normHamming(data(), o.data(), kBytes); }
+
+        string hex() const {
+            char buf[kBytes * 2 + 1];
+            snprintf(buf, sizeof(buf), "%016llx%016llx%016llx%016llx", bits[0], bits[1], bits[2], bits[3]);
+            return buf;
+        }
+        static bool fromHex(const string& s, PageHash& h) {
+            if (s.size() != kBytes * 2) return false;
+            for (int i = 0; i < 4; ++i) {
+                char* end = nullptr;
+                string part = s.substr(i * 16, 16);
+                h.bits[i] = strtoull(part.c_str(), &end, 16);
+                if (end != part.c_str() + 16) return false;
+            }
+            return true;
+        }
+    };
+
+    // Works on any getWarpedA4 output; the page is shrunk first, so the cost is
+    // one INTER_AREA pass over it plus a 64x64 DCT.
+    static PageHash pageHash(const Mat& warped) {
+        DS_PROFILE_SCOPE("pageHash");
+        Mat small, gray, f, freq;
+        resize(warped, small, Size(64, 64), 0, 0, INTER_AREA);
+        if (small.channels() == 3) cvtColor(small, gray, COLOR_BGR2GRAY);
+        else gray = small;
+        gray.convertTo(f, CV_32F);
+        dct(f, freq);
+        float v[256];
+        for (int y = 0; y < 16; ++y)
+            for (int x = 0; x < 16; ++x) v[y * 16 + x] = freq.at<float>(y, x);
+        vector<float> ac(v + 1, v + 256);
+        nth_element(ac.begin(), ac.begin() + ac.size() / 2, ac.end());
+        float median = ac[ac.size() / 2];
+        PageHash h;
+        for (int i = 1; i < 256; ++i)
+            if (v[i] > median) h.bits[i >> 6] |= 1ULL << (i & 63);
+        return h;
+    }
+
+    // Near-duplicate lookup over the pages of one run, built as they come in.
+    // Each page hash goes into several cvflann LSH tables keyed on different
+    // random bit subsets; a query only looks at the pages sharing a bucket in
+    // some table and checks their exact Hamming distance, so a run costs about
+    // constant time per page instead of comparing every pair. A near duplicate
+    // (distance <= maxDistance) shares a bucket in at least one table with high
+    // probability: at 32 of 256 bits apart, 20 tables of 12-bit keys miss about
+    // 1 pair in 75, and closer pairs almost never; unrelated pages (about 128
+    // bits apart) share a bucket with about 0.5% of the index.
+    // Pages take turns in input order: findOrAdd for page n waits until pages
+    // 0..n-1 have been looked up or passed over with skipTurn, so the original
+    // of a group is always its earliest input however the workers are
+    // scheduled. Workers must take pages in that order too, then a lookup only
+    // waits for pages already in flight. Duplicates are not added, so a third
+    // shot of a page matches the first one rather than the second.
+    class DuplicateIndex {
+    public:
+        explicit DuplicateIndex(int maxDistance = 32, int tableCount = 20, int keyBits = 12)
+            : maxDist(maxDistance) {
+            for (int i = 0; i < tableCount; ++i)
+                tables.emplace_back(new cvflann::lsh::LshTable<uchar>(PageHash::kBytes, keyBits));
+        }
+
+        // Returns the name of the closest earlier page within maxDistance and
+        // its distance; with none, adds this page under name and returns "".
+        // order: the page's input index, each one used once here or in skipTurn.
+        string findOrAdd(size_t order, const PageHash& h, const string& name, int* distance = nullptr) {
+            DS_PROFILE_SCOPE("dedupeLookup");
+            unique_lock<mutex> lk(mtx);
+            turnTaken.wait(lk, [&]() { return turn == order; });
+            string original = lookupOrAdd(h, name, distance);
+            endTurn(order);
+            return original;
+        }
+
+        // A page without a hash (unreadable): lets the pages after it go on.
+        void skipTurn(size_t order) {
+            lock_guard<mutex> lk(mtx);
+            endTurn(order);
+        }
+
+        int maxDistance() const { return maxDist; }
+        size_t pages() const { return hashes.size(); }
+        size_t duplicates() const { return duplicateCount; }
+
+    private:
+        int maxDist;
+        vector<unique_ptr<cvflann::lsh::LshTable<uchar>>> tables;
+        vector<PageHash> hashes;
+        vector<string> names;
+        size_t duplicateCount = 0;
+        size_t turn = 0;        // input index of the page whose turn it is
+        set<size_t> finished;   // later pages already done
+        mutex mtx;
+        condition_variable turnTaken;
+
+        void endTurn(size_t order) {
+            if (order != turn) {
+                finished.insert(order);
+                return;
+            }
+            ++turn;
+            while (finished.erase(turn)) ++turn;
+            turnTaken.notify_all();
+        }
+
+        string lookupOrAdd(const PageHash& h, const string& name, int* distance) {
+            int best = -1, bestDist = maxDist + 1;
+            for (auto& t : tables) {
+                const cvflann::lsh::Bucket* bucket = t->getBucketFromKey(t->getKey(h.data()));
+                if (!bucket) continue;
+                for (unsigned id : *bucket) {
+                    int d = hashes[id].distance(h);
+                    if (d < bestDist || (d == bestDist && (int)id < best)) {
+                        best = (int)id;
+                        bestDist = d;
+                    }
+                }
+            }
+            if (best >= 0) {
+                ++duplicateCount;
+                if (distance) *distance = bestDist;
+                return names[best];
+            }
+            unsigned id = (unsigned)hashes.size();
+            hashes.push_back(h);
+            names.push_back(name);
+            for (auto& t : tables) t->add(id, hashes.back().data());
+            return string();
+        }
+    };
+
+    // A page's turn in a DuplicateIndex. Passes it on when it goes out of scope
+    // without a lookup, so every early return of a worker lets the next pages go.
+    class DedupeTurn {
+    public:
+        DedupeTurn(DuplicateIndex* index, size_t order) : index(index), order(order) {}
+        ~DedupeTurn() { if (index && !taken) index->skipTurn(order); }
+        DedupeTurn(const DedupeTurn&) = delete;
+        DedupeTurn& operator=(const DedupeTurn&) = delete;
+
+        bool active() const { return index != nullptr; }
+        string findOrAdd(const PageHash& h, const string& name, int* distance) {
+            taken = true;
+            return index->findOrAdd(order, h, name, distance);
+        }
+
+    private:
+        DuplicateIndex* index;
+        size_t order;
+        bool taken = false;
+    };
+
+} // namespace DocScanner
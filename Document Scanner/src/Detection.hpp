@@ -0,0 +1,174 @@
+// Detection.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "Core.hpp"
+#include "LineDetector.hpp"
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    enum class DetectorMethod { Contour, Lines, Cascade };
+
+    const char* detectorName(DetectorMethod m) {
+        switch (m) {
+        case DetectorMethod::Lines: return "lines";
+        case DetectorMethod::Cascade: return "cascade";
+        default: return "contour";
+        }
+    }
+
+    bool parseDetectorName(const string& name, DetectorMethod& m) {
+        if (name == "contour") m = DetectorMethod::Contour;
+        else if (name == "lines") m = DetectorMethod::Lines;
+        else if (name == "cascade") m = DetectorMethod::Cascade;
+        else return false;
+        return true;
+    }
+
+    // Runs the full-resolution detector on a downscaled copy and maps the quad back.
+    bool detectOnProxy(const EdgeProxy& px, vector<Point2f>& quad, bool* approximate = nullptr) {
+        if (!findDocumentContour(preProcessForContours(px.image), quad, approximate)) return false;
+        if (px.scale < 1.0)
+            for (auto& p : quad) p *= (float)(1.0 / px.scale);
+        return true;
+    }
+
+    bool detectOnProxy(const Mat& img, vector<Point2f>& quad, int maxSide, bool* approximate = nullptr) {
+        double s = min(1.0, (double)maxSide / max(img.cols, img.rows));
+        if (s >= 1.0) return findDocumentContour(preProcessForContours(img), quad, approximate);
+        Mat small;
+        resize(img, small, Size(), s, s, INTER_AREA);
+        if (!findDocumentContour(preProcessForContours(small), quad, approximate)) return false;
+        for (auto& p : quad) p *= (float)(1.0 / s);
+        return true;
+    }
+
+    // Parts of the confidence score, each in [0, 1].
+    struct QuadScore {
+        double edgeSupport = 0; // outline share lying on image edges
+        double angles = 0;      // 1 while every corner is within 20 degrees of square
+        double area = 0;        // 1 between 15% and 95% of the image
+        bool convex = false;
+        double confidence = 0;
+    };
+
+    // Geometry and evidence check of a quad (any corner order, full-resolution
+    // coordinates) against the edges of a proxy of its image (600px for the
+    // confidence written to manifests).
+    QuadScore scoreQuad(const EdgeProxy& px, const vector<Point2f>& quad) {
+        DS_PROFILE_SCOPE("scoreQuad");
+        QuadScore sc;
+        if (quad.size() != 4 || px.support.empty()) return sc;
+        vector<Point2f> q = reorderPoints(quad);
+        sc.convex = isContourConvex(q);
+        if (!sc.convex) return sc;
+
+        double ratio = contourArea(q) / ((double)px.fullSize.width * px.fullSize.height);
+        // Tiny quads are usually a label or a photo on the page; a quad filling
+        // the whole frame is usually the image border rather than the page.
+        if (ratio < 0.15) sc.area = max(0.0, (ratio - 0.02) / 0.13);
+        else if (ratio > 0.95) sc.area = max(0.0, (1.0 - ratio) / 0.05);
+        else sc.area = 1.0;
+
+        double worst = 0;
+        for (int i = 0; i < 4; ++i) {
+            Point2f a = q[(i + 3) % 4] - q[i], b = q[(i + 1) % 4] - q[i];
+            double c = a.dot(b) / max(1e-6, norm(a) * norm(b));
+            double deg = acos(max(-1.0, min(1.0, c))) * 180.0 / CV_PI;
+            worst = max(worst, abs(deg - 90.0));
+        }
+        sc.angles = worst <= 20.0 ? 1.0 : max(0.0, 1.0 - (worst - 20.0) / 40.0);
+
+        float s = (float)px.scale;
+        for (int i = 0; i < 4; ++i)
+            sc.edgeSupport += segmentSupport(px.support, q[i] * s, q[(i + 1) % 4] * s) / 4;
+
+        // Edge evidence dominates: a well-shaped quad nobody can see is still a guess
+        sc.confidence = sc.edgeSupport * (0.5 + 0.25 * sc.angles + 0.25 * sc.area);
+        return sc;
+    }
+
+    QuadScore scoreQuad(const Mat& img, const vector<Point2f>& quad) {
+        if (quad.size() != 4 || img.empty()) return QuadScore();
+        return scoreQuad(makeEdgeProxy(img, 600), quad);
+    }
+
+    struct Detection {
+        bool found = false;
+        vector<Point2f> quad;    // corners in any order, image coordinates
+        double confidence = 0;
+        string detector;         // which detector produced the quad
+    };
+
+    struct CascadeOptions {
+        double accept = 0.6;     // stop escalating once a detection scores this
+    };
+
+    // Cheap detectors first, expensive ones only for pages they are unsure about.
+    // Order: contour on a 600px proxy, line segments on a 600px proxy, contour at
+    // full resolution. Returns the best-scoring detection seen. The proxy and its
+    // edges are built once and shared by both proxy detectors and every score.
+    Detection detectCascade(const Mat& img, const CascadeOptions& o = CascadeOptions()) {
+        DS_PROFILE_SCOPE("detectCascade");
+        EdgeProxy px = makeEdgeProxy(img, 600);
+        Detection best;
+        auto consider = [&](const char* name, bool ok, const vector<Point2f>& q, bool approximate) {
+            if (!ok || q.size() != 4) return false;
+            double c = scoreQuad(px, q).confidence;
+            if (approximate) c *= 0.5; // minAreaRect fallback
+            if (!best.found || c > best.confidence) {
+                best.found = true;
+                best.quad = q;
+                best.confidence = c;
+                best.detector = name;
+            }
+            return best.confidence >= o.accept;
+        };
+
+        vector<Point2f> q;
+        bool approx = false;
+        if (consider("contour@600", detectOnProxy(px, q, &approx), q, approx)) return best;
+        q.clear();
+        if (consider("lines@600", findDocumentQuadLines(px, q), q, false)) return best;
+        q.clear();
+        approx = false;
+        consider("contour", findDocumentContour(preProcessForContours(img), q, &approx), q, approx);
+        return best;
+    }
+
+    // Runtime-selected page detection. With withConfidence the result is scored;
+    // the line detector and the cascade score on the proxy they detect on, the
+    // contour detector builds one only then. Callers that only want the quad can
+    // pass false (or use detectDocument) and skip the proxy's resize and Canny.
+    Detection detect(const Mat& img, DetectorMethod m, bool withConfidence = true) {
+        if (m == DetectorMethod::Cascade) return detectCascade(img);
+        Detection d;
+        d.detector = detectorName(m);
+        if (m == DetectorMethod::Lines) {
+            EdgeProxy px = makeEdgeProxy(img, LineDetectorParams().proxySide);
+            d.found = findDocumentQuadLines(px, d.quad);
+            if (d.found && withConfidence) d.confidence = scoreQuad(px, d.quad).confidence;
+            return d;
+        }
+        bool approx = false;
+        d.found = findDocumentContour(preProcessForContours(img), d.quad, &approx);
+        if (d.found && withConfidence) d.confidence = scoreQuad(img, d.quad).confidence * (approx ? 0.5 : 1.0);
+        return d;
+    }
+
+    // Quad only, for callers that do not need the score; corners in any order.
+    bool detectDocument(const Mat& img, vector<Point2f>& quad, DetectorMethod m) {
+        if (m == DetectorMethod::Cascade) {
+            Detection d = detectCascade(img);
+            quad = d.quad;
+            return d.found;
+        }
+        if (m == DetectorMethod::Lines) return findDocumentQuadLines(img, quad);
+        return findDocumentContour(preProcessForContours(img), quad);
+    }
+
+} // namespace DocScanner
@@ -0,0 +1,109 @@
+// Enhance.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "Profiler.hpp"
+#include <cmath>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    enum class EnhanceMode { None, MagicColor, Gray };
+
+    struct EnhanceParams {
+        double blackPct = 1.0;   // darkest share mapped to black, per channel
+        double whitePct = 90.0;  // paper: this percentile and above becomes white
+        double gamma = 1.3;      // > 1 darkens mid-tones: bolder text, deeper stamp colours
+    };
+
+    // Percentiles of one channel from a coarse subsample (every 4th row and column).
+    static void channelLevels(const Mat& img, int ch, const EnhanceParams& p, int& lo, int& hi) {
+        int hist[256] = { 0 };
+        int n = 0, cn = img.channels();
+        for (int y = 0; y < img.rows; y += 4) {
+            const uchar* row = img.ptr<uchar>(y);
+            for (int x = 0; x < img.cols; x += 4, ++n) ++hist[row[x * cn + ch]];
+        }
+        int loCount = (int)(n * p.blackPct / 100.0), hiCount = (int)(n * p.whitePct / 100.0);
+        lo = 0;
+        hi = 255;
+        int acc = 0;
+        bool loSet = false;
+        for (int v = 0; v < 256; ++v) {
+            acc += hist[v];
+            if (!loSet && acc > loCount) {
+                lo = v;
+                loSet = true;
+            }
+            if (acc > hiCount) {
+                hi = v;
+                break;
+            }
+        }
+        if (hi - lo < 16) { // flat channel: leave it nearly alone
+            lo = max(0, hi - 16);
+            hi = lo + 16;
+        }
+    }
+
+    // levels -> [0, 1] -> gamma -> 8 bit, as a 256-entry table
+    static void buildLevelsLUT(int lo, int hi, double gamma, uchar* out) {
+        for (int v = 0; v < 256; ++v) {
+            double x = min(1.0, max(0.0, (double)(v - lo) / (hi - lo)));
+            out[v] = saturate_cast<uchar>(255.0 * pow(x, gamma));
+        }
+    }
+
+    // "Magic colour": per-channel levels put the paper at pure white (which also
+    // white-balances it) and stretch contrast, then gamma deepens ink and stamps.
+    // The statistics come from a sparse sample; the image itself is touched once,
+    // by a single 3-channel LUT pass.
+    Mat makeMagicColor(const Mat& warped, const EnhanceParams& p = EnhanceParams()) {
+        if (warped.empty() || warped.channels() != 3) return warped.clone();
+        DS_PROFILE_SCOPE("makeMagicColor");
+        Mat lut(1, 256, CV_8UC3);
+        for (int c = 0; c < 3; ++c) {
+            int lo, hi;
+            channelLevels(warped, c, p, lo, hi);
+            uchar table[256];
+            buildLevelsLUT(lo, hi, p.gamma, table);
+            for (int v = 0; v < 256; ++v) lut.at<Vec3b>(0, v)[c] = table[v];
+        }
+        Mat out;
+        LUT(warped, lut, out);
+        return out;
+    }
+
+    // Greyscale with the same levels/gamma treatment, for forms that must stay grey.
+    Mat makeEnhancedGray(const Mat& warped, const EnhanceParams& p = EnhanceParams()) {
+        if (warped.empty()) return Mat();
+        DS_PROFILE_SCOPE("makeEnhancedGray");
+        Mat gray;
+        if (warped.channels() == 3) cvtColor(warped, gray, COLOR_BGR2GRAY);
+        else gray = warped;
+        int lo, hi;
+        channelLevels(gray, 0, p, lo, hi);
+        Mat lut(1, 256, CV_8U);
+        buildLevelsLUT(lo, hi, p.gamma, lut.ptr<uchar>());
+        Mat out;
+        LUT(gray, lut, out);
+        return out;
+    }
+
+    Mat enhance(const Mat& warped, EnhanceMode m) {
+        if (m == EnhanceMode::MagicColor) return makeMagicColor(warped);
+        if (m == EnhanceMode::Gray) return makeEnhancedGray(warped);
+        return Mat();
+    }
+
+    bool parseEnhanceName(const string& name, EnhanceMode& m) {
+        if (name == "magic") m = EnhanceMode::MagicColor;
+        else if (name == "gray") m = EnhanceMode::Gray;
+        else if (name == "none") m = EnhanceMode::None;
+        else return false;
+        return true;
+    }
+
+} // namespace DocScanner
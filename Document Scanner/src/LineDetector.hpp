@@ -0,0 +1,161 @@
+// LineDetector.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "Core.hpp"
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    struct LineDetectorParams {
+        int proxySide = 600;        // longest side of the image the segments are found on
+        int maxPerGroup = 12;       // longest segments kept per orientation
+        double minSupport = 0.5;    // share of the quad outline that must lie on edges
+        double minAreaRatio = 0.1;  // quad area relative to the image
+    };
+
+    // Canny on a lightly blurred 8-bit grey image, thresholds around its median.
+    static Mat autoCannyEdges(const Mat& gray) {
+        Mat blurred, edges;
+        GaussianBlur(gray, blurred, Size(5, 5), 0);
+        double med = medianU8(blurred);
+        Canny(blurred, edges, max(0.0, 0.67 * med), min(255.0, 1.33 * med));
+        return edges;
+    }
+
+    // Share of points sampled every 3 px along a-b that land on a non-zero pixel.
+    static double segmentSupport(const Mat& support, const Point2f& a, const Point2f& b) {
+        int n = max(2, (int)(norm(b - a) / 3));
+        int hits = 0;
+        for (int i = 0; i <= n; ++i) {
+            Point2f q = a + (b - a) * ((float)i / n);
+            int x = cvRound(q.x), y = cvRound(q.y);
+            if (x >= 0 && y >= 0 && x < support.cols && y < support.rows && support.at<uchar>(y, x)) ++hits;
+        }
+        return (double)hits / (n + 1);
+    }
+
+    // An image shrunk to a detection proxy with its Canny edges and their 3x3
+    // dilation (what outline coverage is measured against). Built once per image
+    // and shared by the proxy detectors and scoreQuad, so a cascade resizes and
+    // runs Canny once however many of them it tries.
+    struct EdgeProxy {
+        double scale = 1;  // proxy pixels per full-resolution pixel
+        Size fullSize;
+        Mat image, gray, edges, support;
+    };
+
+    static EdgeProxy makeEdgeProxy(const Mat& img, int maxSide) {
+        DS_PROFILE_SCOPE("edgeProxy");
+        EdgeProxy px;
+        px.fullSize = img.size();
+        px.scale = min(1.0, (double)maxSide / max(img.cols, img.rows));
+        if (px.scale < 1.0) resize(img, px.image, Size(), px.scale, px.scale, INTER_AREA);
+        else px.image = img;
+        if (px.image.channels() == 3) cvtColor(px.image, px.gray, COLOR_BGR2GRAY);
+        else px.gray = px.image;
+        px.edges = autoCannyEdges(px.gray);
+        dilate(px.edges, px.support, getStructuringElement(MORPH_RECT, Size(3, 3)));
+        return px;
+    }
+
+    // Page finder based on straight edges instead of closed contours: probabilistic
+    // Hough segments on a small proxy are split into near-horizontal and
+    // near-vertical groups, every pair-of-pairs is intersected into a quad, and the
+    // quad whose outline is best covered by Canny edges wins. Tolerates a partly
+    // occluded page edge and textured backgrounds that break contour closing.
+    // outQuad is in full-resolution coordinates.
+    bool findDocumentQuadLines(const EdgeProxy& px, vector<Point2f>& outQuad,
+        const LineDetectorParams& p = LineDetectorParams()) {
+        DS_PROFILE_SCOPE("findDocumentQuadLines");
+        const double s = px.scale;
+        const Mat& gray = px.gray;
+        const Mat& edges = px.edges;
+        const Mat& support = px.support;
+
+        vector<Vec4i> segs;
+        {
+            DS_PROFILE_SCOPE("HoughLinesP");
+            int minSide = min(gray.cols, gray.rows);
+            HoughLinesP(edges, segs, 1, CV_PI / 180, 40, minSide * 0.1, minSide * 0.02);
+        }
+
+        // Split by orientation and keep the longest of each
+        vector<Vec4i> horiz, vert;
+        for (auto& l : segs) {
+            double dx = l[2] - l[0], dy = l[3] - l[1];
+            (abs(dx) >= abs(dy) ? horiz : vert).push_back(l);
+        }
+        auto byLength = [](const Vec4i& a, const Vec4i& b) {
+            return norm(Point(a[2] - a[0], a[3] - a[1])) > norm(Point(b[2] - b[0], b[3] - b[1]));
+        };
+        sort(horiz.begin(), horiz.end(), byLength);
+        sort(vert.begin(), vert.end(), byLength);
+        if (horiz.size() > (size_t)p.maxPerGroup) horiz.resize(p.maxPerGroup);
+        if (vert.size() > (size_t)p.maxPerGroup) vert.resize(p.maxPerGroup);
+        if (horiz.size() < 2 || vert.size() < 2) return false;
+
+        auto intersect = [](const Vec4i& a, const Vec4i& b, Point2f& out) {
+            Point2f p(a[0], a[1]), r(a[2] - a[0], a[3] - a[1]);
+            Point2f q(b[0], b[1]), t(b[2] - b[0], b[3] - b[1]);
+            float den = r.x * t.y - r.y * t.x;
+            if (abs(den) < 1e-6f) return false;
+            float u = ((q.x - p.x) * t.y - (q.y - p.y) * t.x) / den;
+            out = p + r * u;
+            return true;
+        };
+
+        DS_PROFILE_SCOPE("scoreQuads");
+        double imgArea = (double)gray.cols * gray.rows;
+        float margin = 0.05f * max(gray.cols, gray.rows);
+        Rect2f bounds(-margin, -margin, gray.cols + 2 * margin, gray.rows + 2 * margin);
+        double bestScore = -1;
+        vector<Point2f> best;
+        for (size_t h0 = 0; h0 < horiz.size(); ++h0)
+            for (size_t h1 = h0 + 1; h1 < horiz.size(); ++h1)
+                for (size_t v0 = 0; v0 < vert.size(); ++v0)
+                    for (size_t v1 = v0 + 1; v1 < vert.size(); ++v1) {
+                        Point2f c[4];
+                        if (!intersect(horiz[h0], vert[v0], c[0]) || !intersect(horiz[h0], vert[v1], c[1]) ||
+                            !intersect(horiz[h1], vert[v1], c[2]) || !intersect(horiz[h1], vert[v0], c[3]))
+                            continue;
+                        bool inside = true;
+                        for (auto& pt : c) inside = inside && bounds.contains(pt);
+                        if (!inside) continue;
+                        vector<Point2f> quad(c, c + 4);
+                        if (!isContourConvex(quad)) continue;
+                        double areaRatio = contourArea(quad) / imgArea;
+                        if (areaRatio < p.minAreaRatio) continue;
+
+                        double sup = 0;
+                        for (int i = 0; i < 4; ++i) sup += segmentSupport(support, c[i], c[(i + 1) % 4]);
+                        sup /= 4;
+                        if (sup < p.minSupport) continue;
+                        // Prefer well-covered outlines; area breaks ties towards the page over inner boxes
+                        double score = sup + 0.25 * areaRatio;
+                        if (score > bestScore) {
+                            bestScore = score;
+                            best = quad;
+                        }
+                    }
+        if (best.empty()) return false;
+
+        outQuad.clear();
+        for (auto& pt : best) {
+            Point2f q = pt * (float)(1.0 / s);
+            q.x = min(max(q.x, 0.0f), (float)(px.fullSize.width - 1));
+            q.y = min(max(q.y, 0.0f), (float)(px.fullSize.height - 1));
+            outQuad.push_back(q);
+        }
+        return true;
+    }
+
+    bool findDocumentQuadLines(const Mat& img, vector<Point2f>& outQuad,
+        const LineDetectorParams& p = LineDetectorParams()) {
+        return findDocumentQuadLines(makeEdgeProxy(img, p.proxySide), outQuad, p);
+    }
+
+} // namespace DocScanner
@@ -0,0 +1,378 @@
+// LiveScanner.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "Core.hpp"
+#include "Detection.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    struct TrackerOptions {
+        int proxyWidth = 640;          // detection and tracking run at this width
+        int keyframeInterval = 30;     // full detection at least this often (frames)
+        double minConfidence = 0.5;    // re-detect below this
+        int maxFeatures = 150;
+        DetectorMethod detector = DetectorMethod::Contour; // keyframe detector
+    };
+
+    // Follows the page quad across video frames. Full page detection runs only
+    // on keyframes; in between, features on and around the page are tracked with
+    // pyramidal Lucas-Kanade and the quad is moved by the RANSAC homography.
+    class QuadTracker {
+    public:
+        explicit QuadTracker(const TrackerOptions& o = TrackerOptions()) : opt(o) {}
+
+        // Takes effect from the next keyframe.
+        void setDetector(DetectorMethod m) { opt.detector = m; }
+
+        void reset() {
+            prevGray.release();
+            pts.clear();
+            quadProxy.clear();
+            conf = 0;
+            framesSinceKey = 0;
+        }
+
+        // Returns true when a quad (frame coordinates) is available for this frame.
+        bool update(const Mat& frame) {
+            DS_PROFILE_SCOPE("trackQuad");
+            if (frame.empty()) return false;
+            scale = min(1.0, (double)opt.proxyWidth / frame.cols);
+            Mat small, gray;
+            if (scale < 1.0) resize(frame, small, Size(), scale, scale, INTER_AREA);
+            else small = frame;
+            cvtColor(small, gray, COLOR_BGR2GRAY);
+
+            keyframe = false;
+            bool tracked = !quadProxy.empty() && !prevGray.empty() && track(gray);
+            if (!tracked || conf < opt.minConfidence || ++framesSinceKey >= opt.keyframeInterval)
+                detect(small, gray);
+
+            prevGray = gray;
+            return !quadProxy.empty();
+        }
+
+        vector<Point2f> quad() const {
+            vector<Point2f> q = quadProxy;
+            for (auto& p : q) p *= (float)(1.0 / scale);
+            return q;
+        }
+
+        double confidence() const { return conf; }
+        bool lastWasKeyframe() const { return keyframe; }
+
+    private:
+        TrackerOptions opt;
+        Mat prevGray;
+        vector<Point2f> pts, quadProxy;
+        size_t seeded = 0;
+        double conf = 0, scale = 1.0;
+        int framesSinceKey = 0;
+        bool keyframe = false;
+
+        void detect(const Mat& small, const Mat& gray) {
+            DS_PROFILE_SCOPE("keyframeDetect");
+            keyframe = true;
+            framesSinceKey = 0;
+            vector<Point2f> q;
+            if (!detectDocument(small, q, opt.detector)) {
+                quadProxy.clear();
+                pts.clear();
+                conf = 0;
+                return;
+            }
+            quadProxy = reorderPoints(q);
+
+            // Seed features in a band around the page so both the page content and its
+            // border contribute; the corners themselves are tracked as well.
+            Mat mask = Mat::zeros(gray.size(), CV_8U);
+            vector<Point> poly;
+            for (auto& p : quadProxy) poly.push_back(Point(cvRound(p.x), cvRound(p.y)));
+            fillConvexPoly(mask, poly, Scalar(255));
+            dilate(mask, mask, getStructuringElement(MORPH_RECT, Size(15, 15)));
+            goodFeaturesToTrack(gray, pts, opt.maxFeatures, 0.01, 7, mask);
+            pts.insert(pts.end(), quadProxy.begin(), quadProxy.end());
+            seeded = pts.size();
+            conf = 1.0;
+        }
+
+        bool track(const Mat& gray) {
+            if (pts.size() < 8) return false;
+            vector<Point2f> next;
+            vector<uchar> status;
+            vector<float> err;
+            calcOpticalFlowPyrLK(prevGray, gray, pts, next, status, err, Size(21, 21), 3);
+
+            vector<Point2f> from, to;
+            for (size_t i = 0; i < pts.size(); ++i)
+                if (status[i]) {
+                    from.push_back(pts[i]);
+                    to.push_back(next[i]);
+                }
+            if (from.size() < 8) return false;
+
+            vector<uchar> inliers;
+            Mat H = findHomography(from, to, RANSAC, 3.0, inliers);
+            if (H.empty()) return false;
+
+            pts.clear();
+            for (size_t i = 0; i < to.size(); ++i)
+                if (inliers[i]) pts.push_back(to[i]);
+            // Confidence: share of seeded features still agreeing with one homography
+            conf = seeded ? (double)pts.size() / seeded : 0.0;
+
+            vector<Point2f> moved;
+            perspectiveTransform(quadProxy, moved, H);
+            if (!isContourConvex(moved)) return false;
+            quadProxy = moved;
+            return true;
+        }
+    };
+
+    struct AutoCaptureOptions {
+        int stableFrames = 10;         // consecutive steady frames before the shot
+        double maxJitter = 0.004;      // mean corner motion per frame, share of frame diagonal
+        double minSharpness = 80.0;    // Laplacian variance of the low-res page crop
+        int sharpnessSide = 320;       // crop is reduced to this longest side first
+        double rearmMotion = 0.05;     // page must move this far (or be lost) before the next shot
+        BinarizeMethod binarize = BinarizeMethod::Adaptive;
+    };
+
+    // Takes the shot once the tracked quad has held still and the page is in focus.
+    // Per-frame checks only touch a small crop; the full-resolution warp and
+    // binarization run on a worker thread so the preview loop keeps its rate.
+    class AutoCapture {
+    public:
+        explicit AutoCapture(const AutoCaptureOptions& o = AutoCaptureOptions()) : opt(o) {}
+
+        void reset() {
+            prevQuad.clear();
+            shotQuad.clear();
+            steady = 0;
+            sharp = 0;
+            armed = true;
+        }
+
+        // Feed every live frame with the tracker's quad (frame coordinates, empty when
+        // lost). Returns true when a capture was started on this frame.
+        bool update(const Mat& frame, const vector<Point2f>& quad) {
+            DS_PROFILE_SCOPE("autoCapture");
+            if (quad.size() != 4 || frame.empty()) {
+                prevQuad.clear();
+                steady = 0;
+                armed = true;
+                return false;
+            }
+            double diag = sqrt((double)frame.cols * frame.cols + (double)frame.rows * frame.rows);
+            if (!armed && cornerMotion(quad, shotQuad) / diag > opt.rearmMotion) armed = true;
+
+            bool still = prevQuad.size() == 4 && cornerMotion(quad, prevQuad) / diag <= opt.maxJitter;
+            prevQuad = quad;
+            steady = still ? steady + 1 : 0;
+            if (!armed || busy() || steady < opt.stableFrames) return false;
+
+            // Sharpness is only worth measuring once the page has settled
+            sharp = sharpness(frame, quad);
+            if (sharp < opt.minSharpness) return false;
+
+            armed = false;
+            shotQuad = quad;
+            Mat full = frame.clone();
+            vector<Point2f> ordered = reorderPoints(quad);
+            BinarizeMethod method = opt.binarize;
+            job = async(launch::async, [full, ordered, method]() {
+                DS_PROFILE_SCOPE("autoCaptureScan");
+                Shot s;
+                s.frame = full;
+                s.quad = ordered;
+                s.color = getWarpedA4(full, ordered);
+                s.bw = binarize(s.color, method);
+                return s;
+            });
+            return true;
+        }
+
+        // True once a started capture has finished; hands over its results and,
+        // if asked, the frame and quad (TL, TR, BR, BL) they were taken from.
+        bool fetch(Mat& color, Mat& bw, Mat* frame = nullptr, vector<Point2f>* quad = nullptr) {
+            if (!job.valid() || job.wait_for(chrono::seconds(0)) != future_status::ready) return false;
+            Shot s = job.get();
+            color = s.color;
+            bw = s.bw;
+            if (frame) *frame = s.frame;
+            if (quad) *quad = s.quad;
+            return true;
+        }
+
+        // Blocks until a started capture has finished; fetch() still hands it over.
+        void wait() {
+            if (job.valid()) job.wait();
+        }
+
+        bool busy() const { return job.valid(); }
+        bool isArmed() const { return armed; }
+        int steadyFrames() const { return steady; }
+        double lastSharpness() const { return sharp; }
+        const AutoCaptureOptions& options() const { return opt; }
+        void setBinarize(BinarizeMethod m) { opt.binarize = m; }
+
+    private:
+        struct Shot {
+            Mat frame, color, bw;
+            vector<Point2f> quad;
+        };
+
+        AutoCaptureOptions opt;
+        vector<Point2f> prevQuad, shotQuad;
+        int steady = 0;
+        double sharp = 0;
+        bool armed = true;
+        future<Shot> job;
+
+        static double cornerMotion(const vector<Point2f>& a, const vector<Point2f>& b) {
+            if (a.size() != 4 || b.size() != 4) return 1e9;
+            double sum = 0;
+            for (int i = 0; i < 4; ++i) sum += norm(a[i] - b[i]);
+            return sum / 4;
+        }
+
+        double sharpness(const Mat& frame, const vector<Point2f>& quad) const {
+            Rect roi = boundingRect(vector<Point>{ Point(quad[0]), Point(quad[1]), Point(quad[2]), Point(quad[3]) })
+                & Rect(0, 0, frame.cols, frame.rows);
+            if (roi.area() < 16) return 0;
+            Mat crop = frame(roi), small, gray, lap;
+            double s = min(1.0, (double)opt.sharpnessSide / max(roi.width, roi.height));
+            if (s < 1.0) resize(crop, small, Size(), s, s, INTER_AREA);
+            else small = crop;
+            cvtColor(small, gray, COLOR_BGR2GRAY);
+            Laplacian(gray, lap, CV_16S, 3);
+            Scalar mean, sd;
+            meanStdDev(lap, mean, sd);
+            return sd[0] * sd[0];
+        }
+    };
+
+    struct LiveFrame {
+        Mat image;
+        unsigned long long seq = 0;              // 1-based index of the grabbed frame
+        chrono::steady_clock::time_point grabbed;
+    };
+
+    // Capture front-end: an ingest thread reads the source as fast as it delivers
+    // and parks each frame in a single slot, replacing (and counting as dropped)
+    // any frame the consumer has not taken yet. The consumer therefore always works
+    // on the newest frame and latency cannot build up behind a slow detector.
+    // The slot is handed over with an atomic pointer exchange, no locks.
+    class FrameGrabber {
+    public:
+        FrameGrabber() = default;
+        FrameGrabber(const FrameGrabber&) = delete;
+        FrameGrabber& operator=(const FrameGrabber&) = delete;
+        ~FrameGrabber() { close(); }
+
+        // A digits-only source is a camera index, anything else a file or URL.
+        bool open(const string& source) {
+            close();
+            bool isIndex = !source.empty() && source.find_first_not_of("0123456789") == string::npos;
+            if (isIndex) cap.open(atoi(source.c_str()));
+            else cap.open(source);
+            if (!cap.isOpened()) return false;
+
+            // Files would otherwise be read far faster than real time and almost
+            // every frame dropped; pace them at their nominal rate.
+            double fps = isIndex ? 0.0 : cap.get(CAP_PROP_FPS);
+            framePeriod = fps > 1.0 ? chrono::duration<double>(1.0 / fps) : chrono::duration<double>(0);
+
+            grabbedCount = 0;
+            droppedCount = 0;
+            deliveredCount = 0;
+            lastLatencyMs = avgLatencyMs = 0;
+            stopFlag = false;
+            endOfStream = false;
+            ingest = thread(&FrameGrabber::run, this);
+            return true;
+        }
+
+        void close() {
+            stopFlag = true;
+            if (ingest.joinable()) ingest.join();
+            delete slot.exchange(nullptr);
+            cap.release();
+        }
+
+        bool isOpen() const { return ingest.joinable(); }
+
+        // True at end of file or when the camera stops delivering and nothing is left in the slot.
+        bool finished() const { return endOfStream.load() && slot.load() == nullptr; }
+
+        // Takes the newest frame, if a new one arrived since the last call.
+        bool take(LiveFrame& out) {
+            LiveFrame* f = slot.exchange(nullptr, memory_order_acquire);
+            if (!f) return false;
+            out = *f;
+            delete f;
+            ++deliveredCount;
+            return true;
+        }
+
+        // Call when the consumer is done with a frame: grab-to-result latency.
+        void frameDone(const LiveFrame& f) {
+            lastLatencyMs = chrono::duration<double, milli>(chrono::steady_clock::now() - f.grabbed).count();
+            avgLatencyMs = avgLatencyMs == 0 ? lastLatencyMs : avgLatencyMs * 0.95 + lastLatencyMs * 0.05;
+        }
+
+        unsigned long long grabbed() const { return grabbedCount.load(); }
+        unsigned long long dropped() const { return droppedCount.load(); }
+        unsigned long long delivered() const { return deliveredCount; }
+        double lastLatency() const { return lastLatencyMs; }
+        double avgLatency() const { return avgLatencyMs; }
+
+    private:
+        VideoCapture cap;
+        thread ingest;
+        atomic<LiveFrame*> slot{ nullptr };
+        atomic<bool> stopFlag{ false }, endOfStream{ false };
+        atomic<unsigned long long> grabbedCount{ 0 }, droppedCount{ 0 };
+        unsigned long long deliveredCount = 0;      // consumer thread only
+        double lastLatencyMs = 0, avgLatencyMs = 0; // consumer thread only
+        chrono::duration<double> framePeriod{ 0 };
+
+        void run() {
+            if (Tracer::enabled()) Tracer::instance().setThreadName("ingest");
+            auto next = chrono::steady_clock::now();
+            while (!stopFlag.load()) {
+                LiveFrame* f = new LiveFrame();
+                {
+                    DS_PROFILE_SCOPE("grab");
+                    if (!cap.read(f->image) || f->image.empty()) {
+                        delete f;
+                        break;
+                    }
+                }
+                f->grabbed = chrono::steady_clock::now();
+                f->seq = ++grabbedCount;
+                LiveFrame* old = slot.exchange(f, memory_order_acq_rel);
+                if (old) {
+                    delete old;
+                    ++droppedCount;
+                }
+                if (framePeriod.count() > 0) {
+                    next += chrono::duration_cast<chrono::steady_clock::duration>(framePeriod);
+                    auto now = chrono::steady_clock::now();
+                    if (next > now) this_thread::sleep_until(next);
+                    else next = now; // fell behind; don't try to catch up
+                }
+            }
+            endOfStream = true;
+        }
+    };
+
+} // namespace DocScanner
@@ -0,0 +1,328 @@
+// MemTrack.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    // Live/peak byte accounting for Mat buffers (through a MatAllocator wrapper) and
+    // operator new. Stages opened with DS_PROFILE_SCOPE record how far memory rose
+    // above its level at stage entry. Stage and page figures are attributed to the
+    // allocating thread, so buffers that OpenCV's own worker threads allocate
+    // inside parallel_for_ only show up in the process-wide peak.
+    // The operator new hook runs before anything else is set up, including this
+    // tracker and the CRT's own containers, so everything it touches is
+    // constant-initialized: atomic counters and a trivial thread_local with a
+    // fixed-depth stage stack. The maps behind stageStats() and endPage() are
+    // created and filled with the hook bypassed, so they neither re-enter it
+    // nor show up in the figures.
+    class MemTracker {
+    public:
+        struct StageMem {
+            long long lastPeak = 0; // bytes above stage entry, most recent call
+            long long maxPeak = 0;  // over all calls
+            unsigned long long calls = 0;
+        };
+
+        static const int kMaxDepth = 64; // deeper stages count towards the 64th
+
+        // While alive, operator new blocks of the calling thread are not counted.
+        class HookBypass {
+        public:
+            HookBypass() : prev(threadHot().bypass) { threadHot().bypass = true; }
+            ~HookBypass() { threadHot().bypass = prev; }
+
+        private:
+            bool prev;
+        };
+
+        static MemTracker& instance() {
+            // never destroyed: blocks may still be freed by late static destructors
+            alignas(MemTracker) static char storage[sizeof(MemTracker)];
+            static MemTracker* m = create(storage);
+            return *m;
+        }
+
+        static bool enabled() { return counters().on.load(memory_order_relaxed); }
+        static bool bypassed() { return threadHot().bypass; }
+
+        // Installs (or removes) the tracking Mat allocator; Mats allocated while
+        // enabled keep being accounted until they are released.
+        void setEnabled(bool e) {
+            Counters& c = counters();
+            if (e == c.on.load()) return;
+            if (e) {
+                tracking.inner = Mat::getDefaultAllocator();
+                Mat::setDefaultAllocator(&tracking);
+            }
+            else Mat::setDefaultAllocator(tracking.inner);
+            c.on.store(e, memory_order_relaxed);
+        }
+
+        long long liveBytes() const { return counters().live.load(memory_order_relaxed); }
+        long long peakBytes() const { return counters().peak.load(memory_order_relaxed); }
+        void resetPeak() { counters().peak.store(counters().live.load()); }
+
+        // Called from the hooks: no allocation, no locks, no dynamic initialization.
+        static void onAlloc(size_t n) {
+            Counters& c = counters();
+            long long now = c.live.fetch_add((long long)n, memory_order_relaxed) + (long long)n;
+            long long p = c.peak.load(memory_order_relaxed);
+            while (now > p && !c.peak.compare_exchange_weak(p, now, memory_order_relaxed)) {}
+            ThreadHot& t = threadHot();
+            t.live += (long long)n;
+            if (t.depth > 0) {
+                Frame& top = t.frames[min(t.depth, kMaxDepth) - 1];
+                if (t.live > top.peakLive) top.peakLive = t.live;
+            }
+        }
+
+        static void onFree(size_t n) {
+            counters().live.fetch_sub((long long)n, memory_order_relaxed);
+            threadHot().live -= (long long)n;
+        }
+
+        void pushStage(const char* name) {
+            ThreadHot& t = threadHot();
+            if (t.depth < kMaxDepth) {
+                Frame& f = t.frames[t.depth];
+                f.name = name;
+                f.baseLive = f.peakLive = t.live;
+            }
+            ++t.depth;
+        }
+
+        void popStage() {
+            ThreadHot& t = threadHot();
+            if (t.depth == 0) return;
+            if (t.depth-- > kMaxDepth) return;
+            Frame f = t.frames[t.depth];
+            if (t.depth > 0 && f.peakLive > t.frames[t.depth - 1].peakLive)
+                t.frames[t.depth - 1].peakLive = f.peakLive;
+            long long rise = f.peakLive - f.baseLive;
+
+            HookBypass bypass;
+            long long& pagePeak = pageStages()[f.name];
+            if (rise > pagePeak) pagePeak = rise;
+
+            lock_guard<mutex> lk(mtx);
+            StageMem& s = stages[f.name];
+            s.lastPeak = rise;
+            if (rise > s.maxPeak) s.maxPeak = rise;
+            ++s.calls;
+        }
+
+        // Per-page breakdown for the calling thread: call beginPage() before the
+        // page's stages, endPage() after them.
+        void beginPage() {
+            HookBypass bypass;
+            pageStages().clear();
+        }
+        map<string, long long> endPage() {
+            map<string, long long> out;
+            HookBypass bypass;
+            out.swap(pageStages());
+            return out;
+        }
+
+        map<string, StageMem> stageStats() {
+            lock_guard<mutex> lk(mtx);
+            return stages;
+        }
+
+        void reset() {
+            HookBypass bypass;
+            lock_guard<mutex> lk(mtx);
+            stages.clear();
+            resetPeak();
+        }
+
+    private:
+        struct Frame {
+            const char* name;
+            long long baseLive, peakLive;
+        };
+
+        struct Counters {
+            atomic<bool> on{ false };
+            atomic<long long> live{ 0 }, peak{ 0 };
+        };
+
+        // Trivial, so it needs no construction and frees during thread teardown stay safe.
+        struct ThreadHot {
+            long long live;
+            int depth;
+            bool bypass;
+            Frame frames[kMaxDepth];
+        };
+
+        // Forwards to the previous default allocator and counts non-user buffers.
+        class TrackingAllocator : public MatAllocator {
+        public:
+            MatAllocator* inner = nullptr;
+
+            UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                AccessFlag flags, UMatUsageFlags usageFlags) const override {
+                UMatData* u = inner->allocate(dims, sizes, type, data, step, flags, usageFlags);
+                if (u) {
+                    u->currAllocator = this;
+                    if (!(u->flags & UMatData::USER_ALLOCATED)) MemTracker::onAlloc(u->size);
+                }
+                return u;
+            }
+
+            bool allocate(UMatData* u, AccessFlag accessFlags, UMatUsageFlags usageFlags) const override {
+                return inner->allocate(u, accessFlags, usageFlags);
+            }
+
+            void deallocate(UMatData* u) const override {
+                if (!u) return;
+                if (!(u->flags & UMatData::USER_ALLOCATED)) MemTracker::onFree(u->size);
+                u->currAllocator = inner;
+                inner->deallocate(u);
+            }
+        };
+
+        mutex mtx;
+        map<string, StageMem> stages; // touched with the hook bypassed
+        TrackingAllocator tracking;
+
+        static MemTracker* create(void* storage) {
+            HookBypass bypass;
+            return new (storage) MemTracker;
+        }
+
+        static Counters& counters() {
+            static Counters c; // constant-initialized: no guard, safe from the first operator new
+            return c;
+        }
+
+        static ThreadHot& threadHot() {
+            static thread_local ThreadHot t;
+            return t;
+        }
+
+        static map<string, long long>& pageStages() {
+            static thread_local unique_ptr<map<string, long long>> m;
+            if (!m) {
+                HookBypass bypass;
+                m.reset(new map<string, long long>());
+            }
+            return *m;
+        }
+    };
+
+    // Header in front of every operator new block: the size, and whether the block
+    // was counted (tracking may be toggled while the block is alive).
+    struct alignas(16) NewBlockHeader {
+        size_t size;
+        size_t tracked;
+    };
+
+    inline void* trackedMalloc(size_t n) {
+        NewBlockHeader* h = (NewBlockHeader*)malloc(sizeof(NewBlockHeader) + n);
+        if (!h) return nullptr;
+        h->size = n;
+        h->tracked = MemTracker::enabled() && !MemTracker::bypassed() ? 1 : 0;
+        if (h->tracked) MemTracker::onAlloc(n);
+        return h + 1;
+    }
+
+    inline void trackedFree(void* p) {
+        if (!p) return;
+        NewBlockHeader* h = (NewBlockHeader*)p - 1;
+        if (h->tracked) MemTracker::onFree(h->size);
+        free(h);
+    }
+
+    // Over-aligned blocks: the header sits just below the returned address, which
+    // is one alignment step (at least one header) into an aligned allocation.
+    inline size_t alignedHeaderOffset(size_t align) {
+        return align > sizeof(NewBlockHeader) ? align : sizeof(NewBlockHeader);
+    }
+
+    inline void* trackedAlignedMalloc(size_t n, size_t align) {
+        size_t off = alignedHeaderOffset(align);
+#ifdef _WIN32
+        char* base = (char*)_aligned_malloc(off + n, align);
+#else
+        void* raw = nullptr;
+        char* base = posix_memalign(&raw, align < sizeof(void*) ? sizeof(void*) : align, off + n) == 0 ? (char*)raw : nullptr;
+#endif
+        if (!base) return nullptr;
+        NewBlockHeader* h = (NewBlockHeader*)(base + off) - 1;
+        h->size = n;
+        h->tracked = MemTracker::enabled() && !MemTracker::bypassed() ? 1 : 0;
+        if (h->tracked) MemTracker::onAlloc(n);
+        return base + off;
+    }
+
+    inline void trackedAlignedFree(void* p, size_t align) {
+        if (!p) return;
+        NewBlockHeader* h = (NewBlockHeader*)p - 1;
+        if (h->tracked) MemTracker::onFree(h->size);
+        char* base = (char*)p - alignedHeaderOffset(align);
+#ifdef _WIN32
+        _aligned_free(base);
+#else
+        free(base);
+#endif
+    }
+
+} // namespace DocScanner
+
+// Replacement global operator new/delete, so --memtrack also counts plain heap
+// blocks besides Mat buffers. Opt-in: every allocation then carries a 16-byte
+// header and two checks even with tracking off, so only a profiling build should
+// define DS_MEM_HOOK (DS_NO_NEW_HOOK, set in the Benchmark project, overrides it).
+// Each executable includes this header from a single translation unit.
+#if defined(DS_MEM_HOOK) && !defined(DS_NO_NEW_HOOK)
+void* operator new(size_t n) {
+    void* p = DocScanner::trackedMalloc(n);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t n) {
+    void* p = DocScanner::trackedMalloc(n);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return DocScanner::trackedMalloc(n); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return DocScanner::trackedMalloc(n); }
+void operator delete(void* p) noexcept { DocScanner::trackedFree(p); }
+void operator delete[](void* p) noexcept { DocScanner::trackedFree(p); }
+void operator delete(void* p, size_t) noexcept { DocScanner::trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept { DocScanner::trackedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { DocScanner::trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { DocScanner::trackedFree(p); }
+#ifdef __cpp_aligned_new
+void* operator new(size_t n, std::align_val_t a) {
+    void* p = DocScanner::trackedAlignedMalloc(n, (size_t)a);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t n, std::align_val_t a) {
+    void* p = DocScanner::trackedAlignedMalloc(n, (size_t)a);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new(size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return DocScanner::trackedAlignedMalloc(n, (size_t)a); }
+void* operator new[](size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return DocScanner::trackedAlignedMalloc(n, (size_t)a); }
+void operator delete(void* p, std::align_val_t a) noexcept { DocScanner::trackedAlignedFree(p, (size_t)a); }
+void operator delete[](void* p, std::align_val_t a) noexcept { DocScanner::trackedAlignedFree(p, (size_t)a); }
+void operator delete(void* p, size_t, std::align_val_t a) noexcept { DocScanner::trackedAlignedFree(p, (size_t)a); }
+void operator delete[](void* p, size_t, std::align_val_t a) noexcept { DocScanner::trackedAlignedFree(p, (size_t)a); }
+void operator delete(void* p, std::align_val_t a, const std::nothrow_t&) noexcept { DocScanner::trackedAlignedFree(p, (size_t)a); }
+void operator delete[](void* p, std::align_val_t a, const std::nothrow_t&) noexcept { DocScanner::trackedAlignedFree(p, (size_t)a); }
+#endif
+#endif
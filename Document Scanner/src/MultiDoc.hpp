@@ -0,0 +1,84 @@
+// MultiDoc.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "Core.hpp"
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    struct ScannedDoc {
+        vector<Point2f> quad; // TL, TR, BR, BL in image coordinates
+        Mat color, bw;
+    };
+
+    // All documents in the image, corners ordered, in reading order (rows of
+    // documents top to bottom, left to right within a row).
+    vector<vector<Point2f>> findDocuments(const Mat& img, double minAreaRatio = 0.01) {
+        DS_PROFILE_SCOPE("findDocuments");
+        vector<vector<Point2f>> quads = findDocumentContours(preProcessForContours(img), minAreaRatio);
+        for (auto& q : quads) q = reorderPoints(q);
+        auto top = [](const vector<Point2f>& q) { return min(q[0].y, q[1].y); };
+        auto bottom = [](const vector<Point2f>& q) { return max(q[2].y, q[3].y); };
+        sort(quads.begin(), quads.end(), [&](const vector<Point2f>& a, const vector<Point2f>& b) {
+            return top(a) < top(b);
+            });
+        // A document starts a new row once its top is below the middle of the row's first one
+        vector<vector<Point2f>> ordered;
+        for (size_t i = 0; i < quads.size();) {
+            float rowMid = 0.5f * (top(quads[i]) + bottom(quads[i]));
+            size_t j = i + 1;
+            while (j < quads.size() && top(quads[j]) < rowMid) ++j;
+            sort(quads.begin() + i, quads.begin() + j, [](const vector<Point2f>& a, const vector<Point2f>& b) {
+                return a[0].x < b[0].x;
+                });
+            ordered.insert(ordered.end(), quads.begin() + i, quads.begin() + j);
+            i = j;
+        }
+        quads.swap(ordered);
+        return quads;
+    }
+
+    // Warps to the quad's own proportions instead of A4: cards and receipts keep
+    // their shape. The longer of each pair of opposite sides sets the size.
+    Mat getWarpedNatural(const Mat& imgOrig, const vector<Point2f>& srcPts) {
+        if (srcPts.size() != 4) return Mat();
+        DS_PROFILE_SCOPE("getWarpedNatural");
+        int w = (int)round(max(euclidDist(srcPts[0], srcPts[1]), euclidDist(srcPts[3], srcPts[2])));
+        int h = (int)round(max(euclidDist(srcPts[0], srcPts[3]), euclidDist(srcPts[1], srcPts[2])));
+        w = max(w, 2);
+        h = max(h, 2);
+
+        vector<Point2f> dst = {
+            Point2f(0, 0),
+            Point2f((float)(w - 1), 0),
+            Point2f((float)(w - 1), (float)(h - 1)),
+            Point2f(0, (float)(h - 1))
+        };
+        Mat M = getPerspectiveTransform(srcPts, dst);
+        Mat warped;
+        {
+            DS_PROFILE_SCOPE("warpPerspective");
+            warpPerspective(imgOrig, warped, M, Size(w, h), INTER_LINEAR, BORDER_CONSTANT);
+        }
+        return warped;
+    }
+
+    // Warps and binarizes every quad; documents are processed in parallel.
+    vector<ScannedDoc> scanDocuments(const Mat& img, const vector<vector<Point2f>>& quads,
+        BinarizeMethod method = BinarizeMethod::Adaptive) {
+        DS_PROFILE_SCOPE("scanDocuments");
+        vector<ScannedDoc> docs(quads.size());
+        parallel_for_(Range(0, (int)quads.size()), [&](const Range& r) {
+            for (int i = r.start; i < r.end; ++i) {
+                docs[i].quad = quads[i];
+                docs[i].color = getWarpedNatural(img, quads[i]);
+                docs[i].bw = binarize(docs[i].color, method);
+            }
+        });
+        return docs;
+    }
+
+} // namespace DocScanner
@@ -0,0 +1,179 @@
+// PoolAllocator.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    // Recycles large Mat buffers by size class. One pool per batch worker: the
+    // same page sizes come round again and again, so after the first page almost
+    // every buffer is reused instead of going back to malloc, and the process
+    // stops fragmenting the heap over long runs.
+    class BufferPool {
+    public:
+        struct Stats {
+            unsigned long long requests = 0, reused = 0;
+            long long cachedBytes = 0;      // free buffers held for reuse
+            long long outstandingBytes = 0; // handed out, not yet returned
+            double reuseRate() const { return requests ? (double)reused / requests : 0.0; }
+        };
+
+        explicit BufferPool(long long keepBytes) : keep(keepBytes) {}
+        ~BufferPool() { trim(0); }
+
+        // Size classes: four steps per power of two, so at most 25% slack.
+        static size_t classSize(size_t n) {
+            size_t p = 1;
+            while (p < n) p <<= 1;
+            size_t step = std::max<size_t>(p / 8, 64);
+            return (n + step - 1) / step * step;
+        }
+
+        void* take(size_t cls) {
+            lock_guard<mutex> lk(mtx);
+            ++st.requests;
+            st.outstandingBytes += (long long)cls;
+            auto it = freeLists.find(cls);
+            if (it != freeLists.end() && !it->second.empty()) {
+                void* p = it->second.back();
+                it->second.pop_back();
+                st.cachedBytes -= (long long)cls;
+                ++st.reused;
+                return p;
+            }
+            return fastMalloc(cls);
+        }
+
+        void give(void* p, size_t cls) {
+            lock_guard<mutex> lk(mtx);
+            st.outstandingBytes -= (long long)cls;
+            freeLists[cls].push_back(p);
+            st.cachedBytes += (long long)cls;
+        }
+
+        // End of a page: everything the page released is back in the free lists;
+        // free buffers beyond the budget, largest classes first.
+        void endPage() { trim(keep); }
+
+        Stats stats() {
+            lock_guard<mutex> lk(mtx);
+            return st;
+        }
+
+    private:
+        long long keep;
+        mutex mtx;
+        map<size_t, vector<void*>> freeLists;
+        Stats st;
+
+        void trim(long long budget) {
+            lock_guard<mutex> lk(mtx);
+            for (auto it = freeLists.rbegin(); it != freeLists.rend() && st.cachedBytes > budget; ++it) {
+                while (!it->second.empty() && st.cachedBytes > budget) {
+                    fastFree(it->second.back());
+                    it->second.pop_back();
+                    st.cachedBytes -= (long long)it->first;
+                }
+            }
+        }
+    };
+
+    // Default Mat allocator that serves the calling thread's BufferPool when one is
+    // bound (ScopedBufferPool) and forwards everything else to the allocator it
+    // replaced. Small buffers and user-data Mats are never pooled. Buffers that
+    // OpenCV's own parallel_for_ threads allocate are not pooled either.
+    // Install before MemTracker is enabled so memory tracking wraps the pool.
+    class PoolAllocator : public MatAllocator {
+    public:
+        static PoolAllocator& instance() {
+            // never destroyed: Mats owned by static objects may be released after main
+            alignas(PoolAllocator) static char storage[sizeof(PoolAllocator)];
+            static PoolAllocator* a = new (storage) PoolAllocator;
+            return *a;
+        }
+
+        size_t minPooledBytes = 64 * 1024;
+
+        void install() {
+            if (installed) return;
+            inner = Mat::getDefaultAllocator();
+            Mat::setDefaultAllocator(this);
+            installed = true;
+        }
+
+        // Pools live as long as the process: Mats from a finished worker may
+        // still be released later.
+        BufferPool* createPool(long long keepBytes = 256LL << 20) {
+            lock_guard<mutex> lk(mtx);
+            pools.emplace_back(new BufferPool(keepBytes));
+            return pools.back().get();
+        }
+
+        static BufferPool*& current() {
+            static thread_local BufferPool* p = nullptr;
+            return p;
+        }
+
+        UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+            AccessFlag flags, UMatUsageFlags usageFlags) const override {
+            BufferPool* pool = current();
+            size_t total = CV_ELEM_SIZE(type);
+            for (int i = dims - 1; i >= 0; --i) {
+                if (step) {
+                    if (data0 && step[i] != Mat::AUTO_STEP) total = step[i];
+                    else step[i] = total;
+                }
+                total *= sizes[i];
+            }
+            if (!pool || data0 || total < minPooledBytes)
+                return inner->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+
+            UMatData* u = new UMatData(this);
+            u->data = u->origdata = (uchar*)pool->take(BufferPool::classSize(total));
+            u->size = total;
+            u->userdata = pool;
+            return u;
+        }
+
+        bool allocate(UMatData* u, AccessFlag accessFlags, UMatUsageFlags usageFlags) const override {
+            if (u && u->userdata) return true;
+            return inner->allocate(u, accessFlags, usageFlags);
+        }
+
+        void deallocate(UMatData* u) const override {
+            if (!u) return;
+            if (!u->userdata) { // not ours (MemTracker hands such buffers back through us)
+                u->currAllocator = inner;
+                inner->deallocate(u);
+                return;
+            }
+            static_cast<BufferPool*>(u->userdata)->give(u->origdata, BufferPool::classSize(u->size));
+            delete u;
+        }
+
+    private:
+        MatAllocator* inner = nullptr;
+        bool installed = false;
+        mutex mtx;
+        vector<unique_ptr<BufferPool>> pools;
+    };
+
+    // Binds a pool to the current thread for the scope's lifetime.
+    class ScopedBufferPool {
+    public:
+        explicit ScopedBufferPool(BufferPool* p) : prev(PoolAllocator::current()) { PoolAllocator::current() = p; }
+        ~ScopedBufferPool() { PoolAllocator::current() = prev; }
+
+    private:
+        BufferPool* prev;
+    };
+
+} // namespace DocScanner
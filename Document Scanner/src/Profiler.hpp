@@ -0,0 +1,178 @@
+// Profiler.hpp
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "Trace.hpp"
+#include "MemTrack.hpp"
+
+using namespace std;
+
+namespace DocScanner {
+
+    // Lightweight stage timer. Stages are opened with DS_PROFILE_SCOPE("name");
+    // when none of the profiler, Tracer and MemTracker is enabled a scope costs
+    // three relaxed atomic loads.
+    // Define DS_DISABLE_PROFILING to compile the scopes out entirely.
+    class Profiler {
+    public:
+        typedef chrono::steady_clock Clock;
+        static const int kHistory = 256; // samples kept per stage for avg/p95
+        static const size_t kMaxFrameEvents = 4096; // flame graph events kept per frame
+
+        struct StageStats {
+            vector<double> samples; // ring buffer, ms
+            int next = 0;
+            unsigned long long calls = 0;
+            double lastMs = 0;
+        };
+
+        struct FrameEvent {
+            string name;
+            double startMs; // relative to frame start
+            double durMs;
+            int depth;
+            bool mainThread;
+        };
+
+        static Profiler& instance() {
+            static Profiler p;
+            return p;
+        }
+
+        static bool enabled() { return instance().on.load(memory_order_relaxed); }
+        void setEnabled(bool e) { on.store(e, memory_order_relaxed); }
+
+        // Marks the start of a GUI frame; events of the finished frame move to lastFrame().
+        void beginFrame() {
+            if (!enabled()) return;
+            lock_guard<mutex> lk(mtx);
+            Clock::time_point now = Clock::now();
+            lastFrameEvents.swap(frameEvents);
+            frameEvents.clear();
+            lastFrameMs = chrono::duration<double, milli>(now - frameStart).count();
+            frameStart = now;
+            mainThreadId = this_thread::get_id();
+            framed = true;
+        }
+
+        void record(const char* name, Clock::time_point start, Clock::time_point end, int depth) {
+            double ms = chrono::duration<double, milli>(end - start).count();
+            lock_guard<mutex> lk(mtx);
+            StageStats& s = stages[name];
+            if ((int)s.samples.size() < kHistory) s.samples.push_back(ms);
+            else s.samples[s.next] = ms;
+            s.next = (s.next + 1) % kHistory;
+            s.lastMs = ms;
+            ++s.calls;
+
+            // Flame events only exist per GUI frame: headless runs never call
+            // beginFrame() and keep just the stage statistics
+            if (!framed || frameEvents.size() >= kMaxFrameEvents) return;
+            FrameEvent ev;
+            ev.name = name;
+            ev.startMs = chrono::duration<double, milli>(start - frameStart).count();
+            ev.durMs = ms;
+            ev.depth = depth;
+            ev.mainThread = this_thread::get_id() == mainThreadId;
+            frameEvents.push_back(ev);
+        }
+
+        struct Summary {
+            string name;
+            unsigned long long calls;
+            double lastMs, avgMs, p95Ms;
+        };
+
+        vector<Summary> summaries() {
+            lock_guard<mutex> lk(mtx);
+            vector<Summary> out;
+            for (auto& kv : stages) {
+                const StageStats& s = kv.second;
+                if (s.samples.empty()) continue;
+                vector<double> sorted = s.samples;
+                sort(sorted.begin(), sorted.end());
+                double sum = 0;
+                for (double v : sorted) sum += v;
+                Summary r;
+                r.name = kv.first;
+                r.calls = s.calls;
+                r.lastMs = s.lastMs;
+                r.avgMs = sum / sorted.size();
+                r.p95Ms = sorted[min(sorted.size() - 1, (size_t)(sorted.size() * 0.95))];
+                out.push_back(r);
+            }
+            return out;
+        }
+
+        vector<FrameEvent> lastFrame(double& frameMs) {
+            lock_guard<mutex> lk(mtx);
+            frameMs = lastFrameMs;
+            return lastFrameEvents;
+        }
+
+        void reset() {
+            lock_guard<mutex> lk(mtx);
+            stages.clear();
+            frameEvents.clear();
+            lastFrameEvents.clear();
+        }
+
+        static int& threadDepth() {
+            static thread_local int depth = 0;
+            return depth;
+        }
+
+    private:
+        atomic<bool> on{ false };
+        mutex mtx;
+        map<string, StageStats> stages;
+        vector<FrameEvent> frameEvents, lastFrameEvents;
+        Clock::time_point frameStart = Clock::now();
+        double lastFrameMs = 0;
+        thread::id mainThreadId = this_thread::get_id();
+        bool framed = false; // beginFrame() was called: a GUI is drawing the flame graph
+    };
+
+    class ScopedStage {
+    public:
+        explicit ScopedStage(const char* stageName)
+            : name(stageName), profiling(Profiler::enabled()), tracing(Tracer::enabled()),
+            memory(MemTracker::enabled()) {
+            if (memory) MemTracker::instance().pushStage(name);
+            if (!profiling && !tracing) return;
+            depth = Profiler::threadDepth()++;
+            start = Profiler::Clock::now();
+        }
+        ~ScopedStage() {
+            if (memory) MemTracker::instance().popStage();
+            if (!profiling && !tracing) return;
+            Profiler::Clock::time_point end = Profiler::Clock::now();
+            if (profiling) Profiler::instance().record(name, start, end, depth);
+            if (tracing) Tracer::instance().add(name, start, end);
+            --Profiler::threadDepth();
+        }
+        ScopedStage(const ScopedStage&) = delete;
+        ScopedStage& operator=(const ScopedStage&) = delete;
+
+    private:
+        const char* name;
+        bool profiling, tracing, memory;
+        int depth = 0;
+        Profiler::Clock::time_point start;
+    };
+
+} // namespace DocScanner
+
+#define DS_CONCAT_INNER(a, b) a##b
+#define DS_CONCAT(a, b) DS_CONCAT_INNER(a, b)
+#ifdef DS_DISABLE_PROFILING
+#define DS_PROFILE_SCOPE(name) ((void)0)
+#else
+#define DS_PROFILE_SCOPE(name) ::DocScanner::ScopedStage DS_CONCAT(dsStage_, __LINE__)(name)
+#endif
@@ -0,0 +1,100 @@
+// ProfilerPanel.hpp
+#pragma once
+#include "imgui/imgui.h"
+#include "Profiler.hpp"
+#include <cstdio>
+
+namespace DocScanner {
+
+    // Colour per stage name so a stage keeps its colour across frames.
+    static ImU32 stageColor(const string& name) {
+        unsigned h = 2166136261u;
+        for (char c : name) h = (h ^ (unsigned char)c) * 16777619u;
+        return IM_COL32(90 + (h & 0x7F), 90 + ((h >> 8) & 0x7F), 90 + ((h >> 16) & 0x7F), 255);
+    }
+
+    // Window with per-stage last/avg/p95 times and a flame bar of the last frame.
+    void drawProfilerPanel(bool* open) {
+        ImGui::SetNextWindowSize(ImVec2(900, 600), ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("Profiler", open)) {
+            ImGui::End();
+            return;
+        }
+        Profiler& prof = Profiler::instance();
+
+        if (ImGui::Button("Reset")) {
+            prof.reset();
+            MemTracker::instance().reset();
+        }
+        ImGui::SameLine();
+        bool trackMem = MemTracker::enabled();
+        if (ImGui::Checkbox("Track memory", &trackMem))
+            MemTracker::instance().setEnabled(trackMem);
+        if (trackMem) {
+            ImGui::SameLine();
+            ImGui::Text("Live: %.1f MB  Peak: %.1f MB",
+                MemTracker::instance().liveBytes() / 1048576.0, MemTracker::instance().peakBytes() / 1048576.0);
+        }
+
+        double frameMs = 0;
+        vector<Profiler::FrameEvent> events = prof.lastFrame(frameMs);
+        ImGui::SameLine();
+        ImGui::Text("Frame: %.2f ms", frameMs);
+
+        // --- Flame bar (UI thread only; nested stages stack downwards)
+        float rowH = ImGui::GetTextLineHeight() + 4.0f;
+        int maxDepth = 0;
+        for (auto& e : events) if (e.mainThread) maxDepth = max(maxDepth, e.depth);
+        ImVec2 barPos = ImGui::GetCursorScreenPos();
+        float barW = ImGui::GetContentRegionAvail().x;
+        float barH = rowH * (maxDepth + 1);
+        ImGui::InvisibleButton("##FlameBar", ImVec2(max(barW, 1.0f), barH));
+        ImDrawList* dl = ImGui::GetWindowDrawList();
+        dl->AddRectFilled(barPos, ImVec2(barPos.x + barW, barPos.y + barH), IM_COL32(40, 40, 40, 255));
+        double span = frameMs > 0 ? frameMs : 1.0;
+        for (auto& e : events) {
+            if (!e.mainThread) continue;
+            float x0 = barPos.x + (float)(max(0.0, e.startMs) / span) * barW;
+            float x1 = barPos.x + (float)(min(span, e.startMs + e.durMs) / span) * barW;
+            if (x1 - x0 < 1.0f) x1 = x0 + 1.0f;
+            float y0 = barPos.y + e.depth * rowH;
+            ImVec2 a(x0, y0), b(x1, y0 + rowH - 1);
+            dl->AddRectFilled(a, b, stageColor(e.name));
+            dl->PushClipRect(a, b, true);
+            dl->AddText(ImVec2(x0 + 2, y0 + 2), IM_COL32(0, 0, 0, 255), e.name.c_str());
+            dl->PopClipRect();
+            if (ImGui::IsMouseHoveringRect(a, b))
+                ImGui::SetTooltip("%s: %.3f ms", e.name.c_str(), e.durMs);
+        }
+
+        // --- Per-stage table
+        vector<Profiler::Summary> rows = prof.summaries();
+        map<string, MemTracker::StageMem> mem = MemTracker::instance().stageStats();
+        if (ImGui::BeginTable("##Stages", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+            ImGui::TableSetupColumn("Stage");
+            ImGui::TableSetupColumn("Calls");
+            ImGui::TableSetupColumn("Last ms");
+            ImGui::TableSetupColumn("Avg ms");
+            ImGui::TableSetupColumn("p95 ms");
+            ImGui::TableSetupColumn("Peak MB");
+            ImGui::TableSetupColumn("Max peak MB");
+            ImGui::TableHeadersRow();
+            for (auto& r : rows) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0); ImGui::TextUnformatted(r.name.c_str());
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%llu", r.calls);
+                ImGui::TableSetColumnIndex(2); ImGui::Text("%.3f", r.lastMs);
+                ImGui::TableSetColumnIndex(3); ImGui::Text("%.3f", r.avgMs);
+                ImGui::TableSetColumnIndex(4); ImGui::Text("%.3f", r.p95Ms);
+                auto m = mem.find(r.name);
+                if (m != mem.end()) {
+                    ImGui::TableSetColumnIndex(5); ImGui::Text("%.2f", m->second.lastPeak / 1048576.0);
+                    ImGui::TableSetColumnIndex(6); ImGui::Text("%.2f", m->second.maxPeak / 1048576.0);
+                }
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+
+} // namespace DocScanner
@@ -0,0 +1,163 @@
+// RemapCache.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "Core.hpp"
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    // Intrinsics from cv::calibrateCamera, as written by the OpenCV calibration
+    // sample: camera_matrix (3x3) and distortion_coefficients (1xN).
+    struct LensCalibration {
+        Mat cameraMatrix, distCoeffs;
+        bool valid() const { return cameraMatrix.rows == 3 && cameraMatrix.cols == 3; }
+    };
+
+    bool loadCalibration(const string& path, LensCalibration& out) {
+        FileStorage fs(path, FileStorage::READ);
+        if (!fs.isOpened()) return false;
+        fs["camera_matrix"] >> out.cameraMatrix;
+        fs["distortion_coefficients"] >> out.distCoeffs;
+        out.cameraMatrix.convertTo(out.cameraMatrix, CV_64F);
+        if (!out.distCoeffs.empty()) out.distCoeffs.convertTo(out.distCoeffs, CV_64F);
+        return out.valid();
+    }
+
+    // Per-pixel source coordinates for warping a quad to a w x h rectangle, kept as
+    // fixed-point maps (convertMaps, CV_16SC2 + interpolation table) so each page
+    // costs one remap. Mounted capture rigs see almost the same quad every shot;
+    // a quad whose corners are all within tolerancePx of a cached one reuses its
+    // maps. With a lens calibration the quad is taken in raw image coordinates and
+    // the undistortion is folded into the same maps.
+    class WarpMapCache {
+    public:
+        explicit WarpMapCache(double tolerancePx = 2.0, size_t capacity = 4)
+            : tol(tolerancePx), cap(capacity) {}
+
+        void setLens(const LensCalibration& l) {
+            lock_guard<mutex> lk(mtx);
+            lens = l;
+            entries.clear();
+        }
+        bool hasLens() const { return lens.valid(); }
+
+        // srcPts ordered TL, TR, BR, BL.
+        Mat warp(const Mat& img, const vector<Point2f>& srcPts, Size outSize) {
+            if (srcPts.size() != 4 || img.empty()) return Mat();
+            DS_PROFILE_SCOPE("warpCached");
+            Mat map1, map2;
+            lookup(srcPts, outSize, map1, map2);
+            Mat out;
+            {
+                DS_PROFILE_SCOPE("remap");
+                remap(img, out, map1, map2, INTER_LINEAR, BORDER_CONSTANT);
+            }
+            return out;
+        }
+
+        unsigned long long hits() {
+            lock_guard<mutex> lk(mtx);
+            return hitCount;
+        }
+        unsigned long long misses() {
+            lock_guard<mutex> lk(mtx);
+            return missCount;
+        }
+
+        void clear() {
+            lock_guard<mutex> lk(mtx);
+            entries.clear();
+        }
+
+    private:
+        struct Entry {
+            vector<Point2f> quad;
+            Size size;
+            Mat map1, map2;
+        };
+
+        double tol;
+        size_t cap;
+        LensCalibration lens;
+        list<Entry> entries; // most recently used first
+        mutex mtx;
+        unsigned long long hitCount = 0, missCount = 0;
+
+        void lookup(const vector<Point2f>& q, Size sz, Mat& map1, Mat& map2) {
+            {
+                lock_guard<mutex> lk(mtx);
+                for (auto it = entries.begin(); it != entries.end(); ++it) {
+                    if (it->size != sz) continue;
+                    bool close = true;
+                    for (int i = 0; i < 4 && close; ++i) close = norm(it->quad[i] - q[i]) <= tol;
+                    if (!close) continue;
+                    entries.splice(entries.begin(), entries, it);
+                    map1 = it->map1;
+                    map2 = it->map2;
+                    ++hitCount;
+                    return;
+                }
+                ++missCount;
+            }
+            // Built outside the lock; two workers missing at once both build, harmlessly
+            Entry e;
+            e.quad = q;
+            e.size = sz;
+            buildMaps(q, sz, e.map1, e.map2);
+            map1 = e.map1;
+            map2 = e.map2;
+            lock_guard<mutex> lk(mtx);
+            entries.push_front(e);
+            if (entries.size() > cap) entries.pop_back();
+        }
+
+        void buildMaps(const vector<Point2f>& q, Size sz, Mat& map1, Mat& map2) const {
+            DS_PROFILE_SCOPE("buildWarpMaps");
+            vector<Point2f> src = q;
+            if (lens.valid()) // the homography holds between undistorted corners
+                undistortPoints(q, src, lens.cameraMatrix, lens.distCoeffs, noArray(), lens.cameraMatrix);
+
+            vector<Point2f> dst = {
+                Point2f(0, 0),
+                Point2f((float)(sz.width - 1), 0),
+                Point2f((float)(sz.width - 1), (float)(sz.height - 1)),
+                Point2f(0, (float)(sz.height - 1))
+            };
+            Mat Hinv = getPerspectiveTransform(dst, src);
+
+            vector<Point2f> grid;
+            grid.reserve((size_t)sz.area());
+            for (int y = 0; y < sz.height; ++y)
+                for (int x = 0; x < sz.width; ++x) grid.push_back(Point2f((float)x, (float)y));
+            vector<Point2f> at;
+            perspectiveTransform(grid, at, Hinv);
+
+            if (lens.valid()) {
+                // Undistorted pixel -> normalized ray -> distorted (raw) pixel
+                double fx = lens.cameraMatrix.at<double>(0, 0), fy = lens.cameraMatrix.at<double>(1, 1);
+                double cx = lens.cameraMatrix.at<double>(0, 2), cy = lens.cameraMatrix.at<double>(1, 2);
+                vector<Point3f> rays;
+                rays.reserve(at.size());
+                for (auto& p : at) rays.push_back(Point3f((float)((p.x - cx) / fx), (float)((p.y - cy) / fy), 1.0f));
+                projectPoints(rays, Vec3d(0, 0, 0), Vec3d(0, 0, 0), lens.cameraMatrix, lens.distCoeffs, at);
+            }
+
+            Mat xy = Mat(at).reshape(2, sz.height); // CV_32FC2, one (x, y) per output pixel
+            convertMaps(xy, noArray(), map1, map2, CV_16SC2);
+        }
+    };
+
+    // getWarpedA4 through the cache; same output size and corner convention.
+    Mat getWarpedA4Cached(WarpMapCache& cache, const Mat& imgOrig, const vector<Point2f>& srcPts,
+        int targetHeight = 842) {
+        int w = (int)round(targetHeight * 210.0 / 297.0);
+        return cache.warp(imgOrig, srcPts, Size(w, targetHeight));
+    }
+
+} // namespace DocScanner
@@ -0,0 +1,221 @@
+// ResultCache.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/utils/filesystem.hpp>
+#include "Profiler.hpp"
+#include "Utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    // 64-bit hash of a byte range, four independent multiply-rotate lanes over
+    // 8-byte words (several GB/s, far below the cost of decoding the image) and a
+    // murmur finalizer. Not cryptographic: it tells re-submitted files apart from
+    // new ones, nothing more.
+    static unsigned long long hashBytes(const uchar* p, size_t n, unsigned long long seed = 0) {
+        const unsigned long long k1 = 0x9E3779B185EBCA87ULL, k2 = 0xC2B2AE3D27D4EB4FULL;
+        auto rotl = [](unsigned long long x, int r) { return (x << r) | (x >> (64 - r)); };
+        auto mix = [&](unsigned long long acc, unsigned long long w) { return rotl(acc + w * k2, 31) * k1; };
+        unsigned long long a = seed + k1 + k2, b = seed + k2, c = seed, d = seed - k1;
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            unsigned long long w[4];
+            memcpy(w, p + i, 32);
+            a = mix(a, w[0]);
+            b = mix(b, w[1]);
+            c = mix(c, w[2]);
+            d = mix(d, w[3]);
+        }
+        unsigned long long h = rotl(a, 1) + rotl(b, 7) + rotl(c, 12) + rotl(d, 18) + n;
+        for (; i + 8 <= n; i += 8) {
+            unsigned long long w;
+            memcpy(&w, p + i, 8);
+            h = rotl(h ^ mix(0, w), 27) * k1 + k2;
+        }
+        for (; i < n; ++i) h = rotl(h ^ (p[i] * k1), 11) * k2;
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static unsigned long long hashString(const string& s) {
+        return hashBytes((const uchar*)s.data(), s.size());
+    }
+
+    static bool readFileBytes(const string& path, vector<uchar>& out) {
+        ifstream in(path, ios::binary | ios::ate);
+        if (!in) return false;
+        streamoff n = in.tellg();
+        if (n <= 0) return false;
+        out.resize((size_t)n);
+        in.seekg(0);
+        return (bool)in.read((char*)out.data(), n);
+    }
+
+    static bool copyFile(const string& from, const string& to) {
+        ifstream in(from, ios::binary);
+        if (!in) return false;
+        ofstream out(to, ios::binary | ios::trunc);
+        if (!out) return false;
+        out << in.rdbuf();
+        return (bool)out;
+    }
+
+    // Detection results (and optionally the encoded outputs) of images seen
+    // before, on disk, keyed by a hash of the file's bytes and of the settings
+    // the result depends on. Re-submitted files (retries, the same attachment
+    // mailed twice) skip detection, and with outputs also warping and encoding.
+    //   <dir>/<key>.yml               quads and how they were found
+    //   <dir>/<key>_<outputs>_<suffix> encoded outputs for one output setting
+    // Bump kVersion whenever detection or output processing changes.
+    class ResultCache {
+    public:
+        static const int kVersion = 1;
+
+        struct Entry {
+            bool foundAuto = false;
+            double confidence = 0;
+            string detector;
+            vector<vector<Point2f>> quads; // one per document, TL, TR, BR, BL; the full frame if nothing was found
+            string pageHash;               // PageHash::hex() of the warped page once a --dedupe run computed it
+        };
+
+        bool open(const string& directory) {
+            dir.clear();
+            if (directory.empty() || !utils::fs::createDirectories(directory)) return false;
+            dir = directory;
+            return true;
+        }
+        bool enabled() const { return !dir.empty(); }
+
+        // detectionSettings: everything the quads depend on (detector, multi-document...).
+        string key(const vector<uchar>& fileBytes, const string& detectionSettings) const {
+            char buf[64];
+            snprintf(buf, sizeof(buf), "%016llx_%llx_%016llx", hashBytes(fileBytes.data(), fileBytes.size()),
+                (unsigned long long)fileBytes.size(), hashString("v" + to_string(kVersion) + "|" + detectionSettings));
+            return buf;
+        }
+
+        bool find(const string& k, Entry& e) {
+            DS_PROFILE_SCOPE("resultCacheFind");
+            bool found = read(k, e);
+            ++(found ? hitCount : missCount);
+            return found;
+        }
+
+        // Written to a temporary file and renamed, so concurrent workers that
+        // meet the same file never leave a half-written entry behind. False if
+        // the entry could not be written or put in place; the old one, if any,
+        // is still there.
+        bool store(const string& k, const Entry& e) {
+            if (!enabled()) return false;
+            string tmp = tempName(entryFile(k));
+            {
+                FileStorage fs(tmp, FileStorage::WRITE);
+                if (!fs.isOpened()) return false;
+                fs << "found_auto" << (int)e.foundAuto << "confidence" << e.confidence << "detector" << e.detector;
+                if (!e.pageHash.empty()) fs << "page_hash" << e.pageHash;
+                fs << "quads" << "[";
+                for (auto& q : e.quads) fs << q;
+                fs << "]";
+            }
+            return publish(tmp, entryFile(k));
+        }
+
+        // outputSettings: everything the encoded outputs depend on beyond the quads.
+        string outputFile(const string& k, const string& outputSettings, const string& suffix) const {
+            char buf[24];
+            snprintf(buf, sizeof(buf), "_%016llx_", hashString(outputSettings));
+            return dir + "/" + k + buf + suffix;
+        }
+
+        // Copies the cached outputs to their destinations ({suffix, destination});
+        // false unless every one of them was there.
+        bool fetchOutputs(const string& k, const string& outputSettings, const vector<pair<string, string>>& files) {
+            DS_PROFILE_SCOPE("resultCacheFetch");
+            for (auto& f : files)
+                if (!copyFile(outputFile(k, outputSettings, f.first), f.second)) return false;
+            ++outputHitCount;
+            return true;
+        }
+
+        void storeOutput(const string& k, const string& outputSettings, const string& suffix, const string& written) {
+            if (!enabled()) return;
+            string f = outputFile(k, outputSettings, suffix), tmp = tempName(f);
+            if (copyFile(written, tmp)) publish(tmp, f);
+            else remove(tmp.c_str());
+        }
+
+        unsigned long long hits() const { return hitCount; }
+        unsigned long long misses() const { return missCount; }
+        unsigned long long outputHits() const { return outputHitCount; }
+
+    private:
+        string dir;
+        atomic<unsigned long long> hitCount{ 0 }, missCount{ 0 }, outputHitCount{ 0 };
+
+        string entryFile(const string& k) const { return dir + "/" + k + ".yml"; }
+
+        bool read(const string& k, Entry& e) const {
+            FileStorage fs;
+            try {
+                if (!fs.open(entryFile(k), FileStorage::READ)) return false;
+                e = Entry();
+                e.foundAuto = (int)fs["found_auto"] != 0;
+                e.confidence = (double)fs["confidence"];
+                e.detector = (string)fs["detector"];
+                e.pageHash = (string)fs["page_hash"];
+                FileNode quads = fs["quads"];
+                for (auto it = quads.begin(); it != quads.end(); ++it) {
+                    vector<Point2f> q;
+                    *it >> q;
+                    if (q.size() != 4) throw cv::Exception(Error::StsParseError, "bad quad", "ResultCache::read", __FILE__, __LINE__);
+                    e.quads.push_back(q);
+                }
+            }
+            catch (const cv::Exception&) { // truncated or foreign file: treat as a miss, it is rewritten
+                return false;
+            }
+            return true;
+        }
+
+        static string tempName(const string& f) {
+            return f + "." + to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+        }
+
+        // Replaces f with tmp in one step, so readers see the old or the new file,
+        // never a mix. A failed replace is retried briefly (another worker may be
+        // reading or replacing the same file) unless f already holds the same
+        // bytes; only then, or after the last try, is tmp simply dropped. True
+        // if f now holds what tmp did.
+        static bool publish(const string& tmp, const string& f) {
+            bool ok = false;
+            for (int attempt = 0; attempt < 5 && !ok; ++attempt) {
+                if (replaceFile(tmp, f)) return true;
+                ok = sameContents(tmp, f); // a concurrent identical write got there first
+                if (!ok) this_thread::sleep_for(chrono::milliseconds(10));
+            }
+            remove(tmp.c_str());
+            return ok;
+        }
+
+        static bool sameContents(const string& a, const string& b) {
+            vector<uchar> x, y;
+            return readFileBytes(a, x) && readFileBytes(b, y) && x == y;
+        }
+    };
+
+} // namespace DocScanner
@@ -0,0 +1,204 @@
+// Session.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "Profiler.hpp"
+#include <sys/stat.h>
+#include <cstdio>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    // One full-resolution buffer that may live in RAM, on disk, or both.
+    struct SpillableMat {
+        Mat mat;
+        string file;        // spill file (or the original image file), empty if never written
+        bool ownsFile = false;
+        long long sourceSize = -1, sourceTime = 0; // of a file not written here, when the page was added
+
+        size_t residentBytes() const { return mat.empty() ? 0 : mat.total() * mat.elemSize(); }
+        bool available() const { return !mat.empty() || !file.empty(); }
+    };
+
+    struct SessionPage {
+        string name;
+        vector<Point2f> quad;  // TL, TR, BR, BL used for the warp
+        Mat preview;           // small copy of the original, always resident
+        SpillableMat original, color, bw;
+    };
+
+    // Pages scanned in one sitting. Previews, quads and names always stay in
+    // memory; the full-resolution original and results are held while the RAM
+    // budget allows and otherwise spilled, least recently used page first, to
+    // PNG files (compression level 1: quick to write, quick to read back).
+    // Originals that came from an unmodified file are simply re-read from it;
+    // the file's size and modification time are recorded when the page is added,
+    // an original whose file changed by spill time is written out like any other
+    // buffer, and one whose file changed after it was dropped fails to reload.
+    class Session {
+    public:
+        explicit Session(size_t budgetBytes = 512u << 20) : budget(budgetBytes) {}
+        ~Session() { clear(); }
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+
+        // sourceFile: where the original can be re-read from, or empty (e.g. camera frames).
+        int addPage(const string& name, const Mat& original, const string& sourceFile,
+            const vector<Point2f>& quad, const Mat& color, const Mat& bw) {
+            DS_PROFILE_SCOPE("sessionAdd");
+            SessionPage p;
+            p.name = name;
+            p.quad = quad;
+            double s = min(1.0, 256.0 / max(original.cols, original.rows));
+            resize(original, p.preview, Size(), s, s, INTER_AREA);
+            p.original.mat = original;
+            p.original.file = sourceFile;
+            if (!sourceFile.empty()) statFile(sourceFile, p.original.sourceSize, p.original.sourceTime);
+            p.color.mat = color;
+            p.bw.mat = bw;
+            pages.push_back(p);
+            int idx = (int)pages.size() - 1;
+            touch(idx);
+            enforceBudget(idx);
+            return idx;
+        }
+
+        // Replace the results of a page (re-warped with a different quad).
+        void updateResults(int idx, const vector<Point2f>& quad, const Mat& color, const Mat& bw) {
+            if (idx < 0 || idx >= (int)pages.size()) return;
+            SessionPage& p = pages[idx];
+            p.quad = quad;
+            dropFile(p.color);
+            dropFile(p.bw);
+            p.color.mat = color;
+            p.bw.mat = bw;
+            touch(idx);
+            enforceBudget(idx);
+        }
+
+        // Full-resolution buffers of a page, read back from disk if they were spilled.
+        bool load(int idx, Mat& original, Mat& color, Mat& bw) {
+            if (idx < 0 || idx >= (int)pages.size()) return false;
+            DS_PROFILE_SCOPE("sessionLoad");
+            SessionPage& p = pages[idx];
+            bool ok = restore(p.original, IMREAD_COLOR);
+            restore(p.color, IMREAD_COLOR);
+            restore(p.bw, IMREAD_GRAYSCALE);
+            original = p.original.mat;
+            color = p.color.mat;
+            bw = p.bw.mat;
+            touch(idx);
+            enforceBudget(idx);
+            return ok;
+        }
+
+        void removePage(int idx) {
+            if (idx < 0 || idx >= (int)pages.size()) return;
+            dropFile(pages[idx].original);
+            dropFile(pages[idx].color);
+            dropFile(pages[idx].bw);
+            pages.erase(pages.begin() + idx);
+            lru.remove(idx);
+            for (auto& i : lru) if (i > idx) --i;
+        }
+
+        void clear() {
+            while (!pages.empty()) removePage((int)pages.size() - 1);
+        }
+
+        void setBudget(size_t bytes) {
+            budget = bytes;
+            enforceBudget(lru.empty() ? -1 : lru.front());
+        }
+
+        size_t budgetBytes() const { return budget; }
+        size_t residentBytes() const {
+            size_t n = 0;
+            for (auto& p : pages) n += p.original.residentBytes() + p.color.residentBytes() + p.bw.residentBytes();
+            return n;
+        }
+        bool isResident(int idx) const { return !pages[idx].original.mat.empty(); }
+        int size() const { return (int)pages.size(); }
+        const SessionPage& page(int idx) const { return pages[idx]; }
+        unsigned long long spills() const { return spillCount; }
+        unsigned long long reloads() const { return reloadCount; }
+
+    private:
+        vector<SessionPage> pages;
+        list<int> lru;            // page indices, most recently used first
+        size_t budget;
+        unsigned long long spillCount = 0, reloadCount = 0;
+
+        void touch(int idx) {
+            lru.remove(idx);
+            lru.push_front(idx);
+        }
+
+        // Spills least recently used pages until the resident total fits; the page
+        // being worked on (keep) is never spilled.
+        void enforceBudget(int keep) {
+            size_t resident = residentBytes();
+            for (auto it = lru.rbegin(); it != lru.rend() && resident > budget; ++it) {
+                if (*it == keep) continue;
+                SessionPage& p = pages[*it];
+                size_t before = p.original.residentBytes() + p.color.residentBytes() + p.bw.residentBytes();
+                spill(p.original);
+                spill(p.color);
+                spill(p.bw);
+                resident -= before;
+            }
+        }
+
+        void spill(SpillableMat& m) {
+            if (m.mat.empty()) return;
+            if (!m.file.empty() && !m.ownsFile && !sourceUnchanged(m)) m.file.clear(); // keep our own copy instead
+            if (m.file.empty()) {
+                DS_PROFILE_SCOPE("sessionSpill");
+                string f = tempfile(".png");
+                if (!imwrite(f, m.mat, { IMWRITE_PNG_COMPRESSION, 1 })) return; // keep it in RAM then
+                m.file = f;
+                m.ownsFile = true;
+                ++spillCount;
+            }
+            m.mat.release();
+        }
+
+        bool restore(SpillableMat& m, int flags) {
+            if (!m.mat.empty()) return true;
+            if (m.file.empty()) return false;
+            if (!m.ownsFile && !sourceUnchanged(m)) {
+                cerr << m.file << " changed on disk since it was added to the session; not re-reading it" << endl;
+                return false;
+            }
+            m.mat = imread(m.file, flags);
+            ++reloadCount;
+            return !m.mat.empty();
+        }
+
+        static bool statFile(const string& f, long long& size, long long& time) {
+            struct stat st;
+            if (stat(f.c_str(), &st) != 0) return false;
+            size = (long long)st.st_size;
+            time = (long long)st.st_mtime;
+            return true;
+        }
+
+        // A source file still holds what was loaded from it: same size and modification time.
+        static bool sourceUnchanged(const SpillableMat& m) {
+            long long size, time;
+            return statFile(m.file, size, time) && size == m.sourceSize && time == m.sourceTime;
+        }
+
+        static void dropFile(SpillableMat& m) {
+            if (m.ownsFile) remove(m.file.c_str());
+            m.file.clear();
+            m.ownsFile = false;
+        }
+    };
+
+} // namespace DocScanner
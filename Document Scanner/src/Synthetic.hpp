@@ -0,0 +1,254 @@
+// Synthetic.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    struct SyntheticParams {
+        double megapixels = 4.0;
+        double aspect = 4.0 / 3.0;       // output width / height
+        double minPageFraction = 0.45;   // page height relative to image height
+        double maxPageFraction = 0.85;
+        double maxRotationDeg = 25.0;
+        double maxPerspective = 0.08;    // corner jitter, fraction of page size
+        double maxBlurSigma = 1.5;       // in pixels at 1 MP, scaled with resolution
+        double noiseSigma = 6.0;
+        bool lighting = true;            // illumination gradient and soft shadow
+    };
+
+    struct SyntheticDocument {
+        Mat image;
+        vector<Point2f> quad; // exact page corners: TL, TR, BR, BL
+    };
+
+    static Scalar randomColor(RNG& rng, int lo, int hi) {
+        return Scalar(rng.uniform(lo, hi), rng.uniform(lo, hi), rng.uniform(lo, hi));
+    }
+
+    static string randomWord(RNG& rng) {
+        static const char* letters = "abcdefghijklmnopqrstuvwxyz";
+        string w;
+        int n = rng.uniform(2, 10);
+        for (int i = 0; i < n; ++i) w += letters[rng.uniform(0, 26)];
+        return w;
+    }
+
+    // Draws a page with paragraphs, a table and a photo block in page pixel units.
+    static Mat renderPage(Size sz, RNG& rng) {
+        Mat page(sz, CV_8UC3, randomColor(rng, 230, 256));
+        double unit = sz.height / 842.0; // layout designed in A4 points
+        int margin = (int)(50 * unit);
+        int y = margin;
+        double fontScale = 0.45 * unit;
+        int lineH = (int)(16 * unit);
+        int thickness = max(1, (int)round(unit));
+        Scalar ink(rng.uniform(0, 60), rng.uniform(0, 60), rng.uniform(0, 60));
+
+        auto paragraph = [&](int lines) {
+            for (int l = 0; l < lines && y < sz.height - margin; ++l) {
+                int x = margin;
+                int right = sz.width - margin - (l == lines - 1 ? rng.uniform(0, sz.width / 2) : 0);
+                while (x < right) {
+                    string w = randomWord(rng);
+                    int base;
+                    Size ts = getTextSize(w, FONT_HERSHEY_SIMPLEX, fontScale, thickness, &base);
+                    if (x + ts.width > right) break;
+                    putText(page, w, Point(x, y + ts.height), FONT_HERSHEY_SIMPLEX, fontScale, ink, thickness, LINE_AA);
+                    x += ts.width + (int)(6 * unit);
+                }
+                y += lineH;
+            }
+            y += lineH;
+        };
+
+        // Title
+        putText(page, randomWord(rng) + " " + randomWord(rng), Point(margin, y + (int)(24 * unit)),
+            FONT_HERSHEY_DUPLEX, 1.1 * unit, ink, thickness + 1, LINE_AA);
+        y += (int)(50 * unit);
+
+        int blocks = rng.uniform(3, 7);
+        for (int b = 0; b < blocks && y < sz.height - margin; ++b) {
+            int kind = rng.uniform(0, 4);
+            if (kind <= 1) paragraph(rng.uniform(3, 9));
+            else if (kind == 2) {
+                // table
+                int rows = rng.uniform(3, 8), cols = rng.uniform(2, 6);
+                int cellH = (int)(20 * unit);
+                int w = sz.width - 2 * margin;
+                if (y + rows * cellH > sz.height - margin) break;
+                for (int r = 0; r <= rows; ++r)
+                    line(page, Point(margin, y + r * cellH), Point(margin + w, y + r * cellH), ink, thickness);
+                for (int c = 0; c <= cols; ++c)
+                    line(page, Point(margin + c * w / cols, y), Point(margin + c * w / cols, y + rows * cellH), ink, thickness);
+                for (int r = 0; r < rows; ++r)
+                    for (int c = 0; c < cols; ++c)
+                        putText(page, randomWord(rng).substr(0, 6), Point(margin + c * w / cols + (int)(4 * unit), y + r * cellH + (int)(14 * unit)),
+                            FONT_HERSHEY_SIMPLEX, fontScale * 0.9, ink, thickness, LINE_AA);
+                y += rows * cellH + lineH;
+            }
+            else {
+                // photo: smooth colour field with a few shapes
+                int h = (int)(rng.uniform(120, 220) * unit);
+                int w = (int)(rng.uniform(150, 300) * unit);
+                if (y + h > sz.height - margin || margin + w > sz.width - margin) continue;
+                Mat small(8, 8, CV_8UC3);
+                rng.fill(small, RNG::UNIFORM, Scalar::all(30), Scalar::all(230));
+                Mat photo;
+                resize(small, photo, Size(w, h), 0, 0, INTER_CUBIC);
+                for (int k = 0; k < 6; ++k)
+                    circle(photo, Point(rng.uniform(0, w), rng.uniform(0, h)), rng.uniform(h / 10, h / 3) + 1,
+                        randomColor(rng, 0, 256), FILLED, LINE_AA);
+                photo.copyTo(page(Rect(margin, y, w, h)));
+                y += h + lineH;
+            }
+        }
+        return page;
+    }
+
+    // Cluttered desk: base colour, wood-like streaks, random objects.
+    static Mat renderBackground(Size sz, RNG& rng) {
+        Mat small(max(2, sz.height / 64), max(2, sz.width / 64), CV_8UC3);
+        Scalar base = randomColor(rng, 40, 200);
+        small.setTo(base);
+        for (int r = 0; r < small.rows; ++r) {
+            Scalar streak = base * (0.8 + 0.4 * rng.uniform(0.0, 1.0));
+            small.row(r).setTo(streak);
+        }
+        Mat bg;
+        resize(small, bg, sz, 0, 0, INTER_LINEAR);
+        double unit = sqrt((double)sz.area()) / 1000.0;
+        int objects = rng.uniform(4, 12);
+        for (int i = 0; i < objects; ++i) {
+            Point c(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+            int r = (int)(rng.uniform(20, 150) * unit) + 1;
+            Scalar col = randomColor(rng, 0, 256);
+            switch (rng.uniform(0, 3)) {
+            case 0: circle(bg, c, r, col, FILLED, LINE_AA); break;
+            case 1: rectangle(bg, Rect(c.x, c.y, r * 2, r), col, FILLED); break;
+            default: line(bg, c, Point(c.x + r * 3, c.y + r), col, max(1, r / 6), LINE_AA); break;
+            }
+        }
+        return bg;
+    }
+
+    // Renders a page onto a cluttered background with random perspective, lighting,
+    // blur and noise. Large outputs are post-processed in row strips to bound memory.
+    SyntheticDocument generateSyntheticDocument(const SyntheticParams& p, RNG& rng) {
+        int H = max(64, (int)round(sqrt(p.megapixels * 1e6 / p.aspect)));
+        int W = max(64, (int)round(H * p.aspect));
+        SyntheticDocument doc;
+        doc.image = renderBackground(Size(W, H), rng);
+
+        // Page placement: scale, rotation, then per-corner jitter
+        double frac = rng.uniform(p.minPageFraction, p.maxPageFraction);
+        double ph = H * frac, pw = ph * 210.0 / 297.0;
+        double ang = rng.uniform(-p.maxRotationDeg, p.maxRotationDeg) * CV_PI / 180.0;
+        double ca = cos(ang), sa = sin(ang);
+        vector<Point2f> quad;
+        Point2f local[4] = { Point2f(-0.5f, -0.5f), Point2f(0.5f, -0.5f), Point2f(0.5f, 0.5f), Point2f(-0.5f, 0.5f) };
+        for (auto& l : local) {
+            double x = l.x * pw + rng.uniform(-p.maxPerspective, p.maxPerspective) * pw;
+            double y = l.y * ph + rng.uniform(-p.maxPerspective, p.maxPerspective) * ph;
+            quad.push_back(Point2f((float)(x * ca - y * sa), (float)(x * sa + y * ca)));
+        }
+        // shrink if the rotated page would not fit, then place it fully inside the frame
+        float x0 = quad[0].x, x1 = quad[0].x, y0q = quad[0].y, y1q = quad[0].y;
+        for (auto& q : quad) {
+            x0 = min(x0, q.x); x1 = max(x1, q.x);
+            y0q = min(y0q, q.y); y1q = max(y1q, q.y);
+        }
+        float fit = min(1.0f, min(0.98f * (W - 1) / (x1 - x0), 0.98f * (H - 1) / (y1q - y0q)));
+        x0 *= fit; x1 *= fit; y0q *= fit; y1q *= fit;
+        float cx = rng.uniform(-x0, (float)(W - 1) - x1);
+        float cy = rng.uniform(-y0q, (float)(H - 1) - y1q);
+        for (auto& q : quad) q = Point2f(q.x * fit + cx, q.y * fit + cy);
+        doc.quad = quad;
+
+        Size pageSz(max(16, (int)round(pw)), max(16, (int)round(ph)));
+        Mat page = renderPage(pageSz, rng);
+        vector<Point2f> src = { Point2f(0, 0), Point2f((float)pageSz.width, 0),
+            Point2f((float)pageSz.width, (float)pageSz.height), Point2f(0, (float)pageSz.height) };
+        Mat M = getPerspectiveTransform(src, quad);
+        warpPerspective(page, doc.image, M, doc.image.size(), INTER_LINEAR, BORDER_TRANSPARENT);
+
+        double blurSigma = rng.uniform(0.0, p.maxBlurSigma) * sqrt(p.megapixels);
+        if (blurSigma > 0.3) GaussianBlur(doc.image, doc.image, Size(), blurSigma);
+
+        // Illumination gain field at low resolution: linear gradient plus a soft shadow
+        Mat gainSmall(32, 32, CV_32F, Scalar(1.0f));
+        if (p.lighting) {
+            double gx = rng.uniform(-0.3, 0.3), gy = rng.uniform(-0.3, 0.3);
+            Point2f sc(rng.uniform(0.0f, 32.0f), rng.uniform(0.0f, 32.0f));
+            float sr = rng.uniform(6.0f, 16.0f), depth = rng.uniform(0.0f, 0.4f);
+            for (int r = 0; r < 32; ++r)
+                for (int c = 0; c < 32; ++c) {
+                    double g = 0.9 + gx * (c / 31.0 - 0.5) + gy * (r / 31.0 - 0.5);
+                    double d = norm(Point2f((float)c, (float)r) - sc) / sr;
+                    g *= 1.0 - depth * exp(-d * d);
+                    gainSmall.at<float>(r, c) = (float)g;
+                }
+        }
+
+        const int strip = 256;
+        Mat gain, gain3, f, noise;
+        for (int y0 = 0; y0 < H; y0 += strip) {
+            int rows = min(strip, H - y0);
+            Mat roi = doc.image.rowRange(y0, y0 + rows);
+            roi.convertTo(f, CV_32FC3);
+            if (p.lighting) {
+                // sample the gain field for this strip only
+                Mat map_x(rows, W, CV_32F), map_y(rows, W, CV_32F);
+                for (int r = 0; r < rows; ++r) {
+                    float* mx = map_x.ptr<float>(r);
+                    float* my = map_y.ptr<float>(r);
+                    float yy = (y0 + r) * 31.0f / max(1, H - 1);
+                    for (int c = 0; c < W; ++c) {
+                        mx[c] = c * 31.0f / max(1, W - 1);
+                        my[c] = yy;
+                    }
+                }
+                remap(gainSmall, gain, map_x, map_y, INTER_LINEAR, BORDER_REPLICATE);
+                Mat ch[] = { gain, gain, gain };
+                merge(ch, 3, gain3);
+                multiply(f, gain3, f);
+            }
+            if (p.noiseSigma > 0) {
+                noise.create(f.size(), CV_32FC3);
+                randn(noise, Scalar::all(0), Scalar::all(p.noiseSigma));
+                f += noise;
+            }
+            f.convertTo(roi, CV_8UC3);
+        }
+        return doc;
+    }
+
+    // Writes count documents plus groundtruth.json (Accuracy.hpp format) into dir.
+    bool writeSyntheticSet(const string& dir, int count, const SyntheticParams& p, uint64 seed) {
+        RNG rng(seed);
+        FileStorage fs(dir + "/groundtruth.json", FileStorage::WRITE | FileStorage::FORMAT_JSON);
+        if (!fs.isOpened()) return false;
+        fs << "description" << "Synthetic documents with exact page corners (TL, TR, BR, BL)";
+        fs << "seed" << (double)seed << "megapixels" << p.megapixels;
+        fs << "images" << "[";
+        for (int i = 0; i < count; ++i) {
+            SyntheticDocument d = generateSyntheticDocument(p, rng);
+            char name[64];
+            snprintf(name, sizeof(name), "synth_%04d.jpg", i);
+            if (!imwrite(dir + "/" + name, d.image, { IMWRITE_JPEG_QUALITY, 92 })) return false;
+            vector<float> coords;
+            for (auto& q : d.quad) { coords.push_back(q.x); coords.push_back(q.y); }
+            fs << "{" << "file" << name << "quad" << coords << "}";
+        }
+        fs << "]";
+        return true;
+    }
+
+} // namespace DocScanner
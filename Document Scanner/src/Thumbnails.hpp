@@ -0,0 +1,296 @@
+// Thumbnails.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/utils/filesystem.hpp>
+#include <GLFW/glfw3.h>
+#include "imgui/imgui.h"
+#include "Profiler.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    // Thumbnails for the image picker. The picker asks for the files it is drawing
+    // every frame; a small worker pool decodes them at reduced resolution (libjpeg
+    // scales JPEGs while decoding, so a 12 MP photo costs a fraction of a full
+    // read), always taking the most recently asked-for file first so whatever is
+    // on screen comes first, and forgetting files that were scrolled past before
+    // their turn. Results go into cells of one shared atlas texture; the least
+    // recently drawn cell is reused once the atlas is full.
+    // With a cache directory set, every decoded thumbnail is also written there
+    // as a small JPEG named after the file's path, size and modification time,
+    // so a folder seen in an earlier run shows up without decoding anything;
+    // a changed file gets a new name and is decoded again. The directory is
+    // trimmed when it is set: thumbnails written more than kCacheMaxDays ago
+    // go, then the oldest ones until it holds at most kCacheMaxBytes.
+    class ThumbnailCache {
+    public:
+        static const int kCell = 64;        // cell side in pixels, the picker's row image height
+        static const int kAtlasSide = 1024; // 16 x 16 cells
+        static const int kCacheMaxDays = 30;
+        static const long long kCacheMaxBytes = 64LL << 20; // about 20000 thumbnails
+
+        explicit ThumbnailCache(int workers = 0) : workerCount(workers) {}
+        ~ThumbnailCache() { stopWorkers(); }
+
+        // Once per frame on the GL thread, before the picker is drawn: uploads
+        // finished thumbnails and drops requests nobody asked for since last frame.
+        void newFrame() {
+            ++frame;
+            vector<Decoded> ready;
+            vector<string> dropped;
+            {
+                lock_guard<mutex> lk(mtx);
+                ready.swap(done);
+                for (auto it = wanted.begin(); it != wanted.end();) {
+                    if (frame - it->second > 2) {
+                        dropped.push_back(it->first);
+                        it = wanted.erase(it);
+                    }
+                    else ++it;
+                }
+            }
+            for (auto& p : dropped) entries[p].queued = false;
+            if (ready.empty()) return;
+            DS_PROFILE_SCOPE("thumbnailUpload");
+            for (auto& d : ready) upload(d);
+        }
+
+        // From the picker (GL thread) for a file it is drawing. True with the atlas
+        // rectangle once the thumbnail is there; otherwise it is queued.
+        bool lookup(const string& path, ImVec2& uv0, ImVec2& uv1, ImVec2& size) {
+            Entry& e = entries[path];
+            if (e.slot >= 0) {
+                slots[e.slot].lastUsed = frame;
+                int x = (e.slot % kPerRow) * kCell, y = (e.slot / kPerRow) * kCell;
+                uv0 = ImVec2((float)x / kAtlasSide, (float)y / kAtlasSide);
+                uv1 = ImVec2((float)(x + e.size.width) / kAtlasSide, (float)(y + e.size.height) / kAtlasSide);
+                size = ImVec2((float)e.size.width, (float)e.size.height);
+                return true;
+            }
+            if (e.failed) return false;
+            startWorkers();
+            lock_guard<mutex> lk(mtx);
+            if (!e.queued) {
+                e.queued = true;
+                wanted[path] = frame;
+                wake.notify_one();
+            }
+            else {
+                auto it = wanted.find(path); // not found: a worker is on it already
+                if (it != wanted.end()) it->second = frame;
+            }
+            return false;
+        }
+
+        GLuint texture() const { return tex; }
+
+        // Before the first lookup; empty turns the disk cache off.
+        void setCacheDir(const string& dir) {
+            cacheDir = dir;
+            if (!cacheDir.empty()) trimCacheDir();
+        }
+
+        // Before the GL context goes away.
+        void release() {
+            stopWorkers();
+            if (tex) glDeleteTextures(1, &tex);
+            tex = 0;
+            entries.clear();
+            slots.clear();
+        }
+
+    private:
+        static const int kPerRow = kAtlasSide / kCell;
+
+        struct Entry {
+            int slot = -1;
+            bool queued = false;  // waiting for or being decoded
+            bool failed = false;  // not an image OpenCV can read
+            Size size;
+        };
+        struct Slot {
+            string owner;
+            long long lastUsed = 0;
+        };
+        struct Decoded {
+            string path;
+            Mat rgba; // empty if decoding failed
+        };
+
+        int workerCount;
+        string cacheDir;   // read by the workers, set before they start
+        long long frame = 0;
+        GLuint tex = 0;
+        unordered_map<string, Entry> entries; // GL thread only
+        vector<Slot> slots;                   // GL thread only
+
+        mutex mtx;
+        condition_variable wake;
+        map<string, long long> wanted;        // path -> frame it was last asked for
+        vector<Decoded> done;
+        vector<thread> workers;
+        bool stopping = false;
+
+        void startWorkers() {
+            if (!workers.empty()) return;
+            int n = workerCount > 0 ? workerCount : max(2, min(4, (int)thread::hardware_concurrency() / 2));
+            stopping = false;
+            for (int i = 0; i < n; ++i) workers.emplace_back([this]() { workerLoop(); });
+        }
+
+        void stopWorkers() {
+            {
+                lock_guard<mutex> lk(mtx);
+                stopping = true;
+                wanted.clear();
+            }
+            wake.notify_all();
+            for (auto& t : workers) t.join();
+            workers.clear();
+            done.clear();
+            for (auto& kv : entries) kv.second.queued = false;
+        }
+
+        void workerLoop() {
+            unique_lock<mutex> lk(mtx);
+            for (;;) {
+                wake.wait(lk, [this]() { return stopping || !wanted.empty(); });
+                if (stopping) return;
+                auto next = max_element(wanted.begin(), wanted.end(),
+                    [](const pair<const string, long long>& a, const pair<const string, long long>& b) { return a.second < b.second; });
+                string path = next->first;
+                wanted.erase(next);
+                lk.unlock();
+                Mat rgba = decode(path);
+                lk.lock();
+                done.push_back({ path, rgba });
+            }
+        }
+
+        // Disk cache file of a source file as it is now: FNV-1a of the path, size,
+        // mtime in nanoseconds (a file rewritten within the same second still
+        // gets a new name).
+        string cacheFile(const string& path, long long size, long long mtimeNs) const {
+            unsigned long long h = 14695981039346656037ULL;
+            for (unsigned char c : path) h = (h ^ c) * 1099511628211ULL;
+            char name[80];
+            snprintf(name, sizeof(name), "%016llx_%lld_%lld.jpg", h, size, mtimeNs);
+            return cacheDir + "/" + name;
+        }
+
+        // Thumbnails of files changed or gone since are never read again, so
+        // without this the directory only grows.
+        void trimCacheDir() {
+            DS_PROFILE_SCOPE("thumbnailCacheTrim");
+            struct CachedThumb {
+                string file;
+                long long size, mtimeNs;
+            };
+            vector<String> names;
+            utils::fs::glob(cacheDir, "*.jpg", names, false, false);
+            long long now = (long long)chrono::duration_cast<chrono::nanoseconds>(
+                chrono::system_clock::now().time_since_epoch()).count();
+            long long oldest = now - kCacheMaxDays * 86400LL * 1000000000LL, total = 0;
+            vector<CachedThumb> kept;
+            for (auto& n : names) {
+                CachedThumb t;
+                t.file = n;
+                if (!fileStatus(t.file, t.size, t.mtimeNs)) continue;
+                if (t.mtimeNs < oldest) remove(t.file.c_str());
+                else {
+                    total += t.size;
+                    kept.push_back(t);
+                }
+            }
+            if (total <= kCacheMaxBytes) return;
+            sort(kept.begin(), kept.end(), [](const CachedThumb& a, const CachedThumb& b) { return a.mtimeNs < b.mtimeNs; });
+            for (size_t i = 0; i < kept.size() && total > kCacheMaxBytes; ++i) {
+                remove(kept[i].file.c_str());
+                total -= kept[i].size;
+            }
+        }
+
+        // From the disk cache when there, else a reduced decode picked from the
+        // file size (big files are big images) that is then added to the cache.
+        Mat decode(const string& path) const {
+            long long bytes = 0, mtimeNs = 0;
+            bool statOk = fileStatus(path, bytes, mtimeNs);
+            string cached = statOk && !cacheDir.empty() ? cacheFile(path, bytes, mtimeNs) : string();
+            if (!cached.empty()) {
+                DS_PROFILE_SCOPE("thumbnailCacheRead");
+                Mat small = imread(cached, IMREAD_COLOR), rgba;
+                if (!small.empty()) {
+                    cvtColor(small, rgba, COLOR_BGR2RGBA);
+                    return rgba;
+                }
+            }
+            DS_PROFILE_SCOPE("thumbnailDecode");
+            int flags = bytes > (1500 << 10) ? IMREAD_REDUCED_COLOR_8
+                : bytes > (300 << 10) ? IMREAD_REDUCED_COLOR_4
+                : bytes > (80 << 10) ? IMREAD_REDUCED_COLOR_2 : IMREAD_COLOR;
+            Mat img = imread(path, flags);
+            if (img.empty()) return Mat();
+            double s = min(1.0, (double)kCell / max(img.cols, img.rows));
+            Mat small, rgba;
+            resize(img, small, Size(max(1, (int)(img.cols * s)), max(1, (int)(img.rows * s))), 0, 0, INTER_AREA);
+            if (!cached.empty()) imwrite(cached, small, { IMWRITE_JPEG_QUALITY, 85 });
+            cvtColor(small, rgba, COLOR_BGR2RGBA);
+            return rgba;
+        }
+
+        int takeSlot(const string& owner) {
+            int idx = -1;
+            if ((int)slots.size() < kPerRow * kPerRow) {
+                slots.push_back(Slot());
+                idx = (int)slots.size() - 1;
+            }
+            else {
+                for (int i = 0; i < (int)slots.size(); ++i)
+                    if (slots[i].lastUsed < frame && (idx < 0 || slots[i].lastUsed < slots[idx].lastUsed)) idx = i;
+                if (idx < 0) return -1; // every cell is on screen
+                entries[slots[idx].owner].slot = -1;
+            }
+            slots[idx].owner = owner;
+            slots[idx].lastUsed = frame;
+            return idx;
+        }
+
+        void upload(const Decoded& d) {
+            Entry& e = entries[d.path];
+            e.queued = false;
+            if (d.rgba.empty()) {
+                e.failed = true;
+                return;
+            }
+            if (!tex) {
+                glGenTextures(1, &tex);
+                glBindTexture(GL_TEXTURE_2D, tex);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, kAtlasSide, kAtlasSide, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            }
+            int slot = takeSlot(d.path);
+            if (slot < 0) return;
+            e.slot = slot;
+            e.size = d.rgba.size();
+            glBindTexture(GL_TEXTURE_2D, tex);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % kPerRow) * kCell, (slot / kPerRow) * kCell,
+                d.rgba.cols, d.rgba.rows, GL_RGBA, GL_UNSIGNED_BYTE, d.rgba.data);
+        }
+    };
+
+} // namespace DocScanner
@@ -0,0 +1,280 @@
+// TiledViewer.hpp
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <GLFW/glfw3.h>
+#include "imgui/imgui.h"
+#include "Profiler.hpp"
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F // not in the GL 1.1 headers shipped with Windows
+#endif
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    // --- Helper: Convert cv::Mat -> OpenGL Texture
+    GLuint matToTexture(const Mat& mat) {
+        if (mat.empty()) return 0;
+        DS_PROFILE_SCOPE("matToTexture");
+        Mat rgb;
+        if (mat.channels() == 1)
+            cvtColor(mat, rgb, COLOR_GRAY2RGB);
+        else
+            cvtColor(mat, rgb, COLOR_BGR2RGB);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        GLuint tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, rgb.cols, rgb.rows, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb.data);
+        return tex;
+    }
+
+    // Zoom/pan viewer that never uploads the whole image at once.
+    // The source is split into fixed-size tiles on a lazily built 2x pyramid;
+    // only tiles intersecting the view are uploaded, at the level matching the
+    // current zoom, and least recently drawn tiles are evicted past maxTiles.
+    // All public coordinates are in original-image pixels.
+    class TiledViewer {
+    public:
+        static const int kTileSize = 512;
+
+        size_t maxTiles = 192;        // resident GL textures (~150 MB of RGB at 512x512)
+        int maxUploadsPerFrame = 12;  // keeps zooming responsive on huge scans
+
+        ~TiledViewer() { releaseTextures(); }
+
+        // Shares the pixel data with img; GL work is deferred to draw().
+        // keepView preserves zoom/pan when the size is unchanged (video frames).
+        void setImage(const Mat& img, bool keepView = false) {
+            bool sameSize = !pyramid.empty() && !img.empty() && img.size() == base().size();
+            releaseTextures();
+            pyramid.clear();
+            if (!img.empty()) pyramid.push_back(img);
+            if (!(keepView && sameSize)) needsFit = true;
+        }
+
+        void clear() { setImage(Mat()); }
+        bool empty() const { return pyramid.empty(); }
+        float zoom() const { return zoomFactor; }
+        void requestFit() { needsFit = true; }
+
+        ImVec2 imageToScreen(const Point2f& p) const {
+            return ImVec2(viewOrigin.x + (p.x - pan.x) * zoomFactor,
+                viewOrigin.y + (p.y - pan.y) * zoomFactor);
+        }
+
+        Point2f screenToImage(const ImVec2& s) const {
+            return Point2f((s.x - viewOrigin.x) / zoomFactor + pan.x,
+                (s.y - viewOrigin.y) / zoomFactor + pan.y);
+        }
+
+        // Screen-space rectangle covered by the image (may exceed the view).
+        void imageScreenRect(ImVec2& outMin, ImVec2& outMax) const {
+            outMin = imageToScreen(Point2f(0, 0));
+            outMax = imageToScreen(Point2f((float)base().cols, (float)base().rows));
+        }
+
+        // Wheel zooms around the cursor; right/middle drag pans, as does left
+        // drag when allowLeftPan is set (i.e. nothing else wants the left button).
+        void handleInput(bool hovered, bool allowLeftPan) {
+            if (empty()) return;
+            ImGuiIO& io = ImGui::GetIO();
+            if (hovered && io.MouseWheel != 0.0f) {
+                Point2f anchor = screenToImage(io.MousePos);
+                float z = zoomFactor * powf(1.2f, io.MouseWheel);
+                z = std::max(minZoom(), std::min(z, 32.0f));
+                zoomFactor = z;
+                pan.x = anchor.x - (io.MousePos.x - viewOrigin.x) / zoomFactor;
+                pan.y = anchor.y - (io.MousePos.y - viewOrigin.y) / zoomFactor;
+            }
+            if (hovered && (ImGui::IsMouseClicked(1) || ImGui::IsMouseClicked(2) ||
+                (allowLeftPan && ImGui::IsMouseClicked(0))))
+                panning = true;
+            if (panning) {
+                bool down = ImGui::IsMouseDown(1) || ImGui::IsMouseDown(2) ||
+                    (allowLeftPan && ImGui::IsMouseDown(0));
+                if (!down) panning = false;
+                else {
+                    pan.x -= io.MouseDelta.x / zoomFactor;
+                    pan.y -= io.MouseDelta.y / zoomFactor;
+                }
+            }
+            clampPan();
+        }
+
+        // Draws the visible part of the image into [origin, origin + size).
+        void draw(ImDrawList* dl, ImVec2 origin, ImVec2 size) {
+            if (empty()) return;
+            viewOrigin = origin;
+            viewSize = size;
+            if (needsFit) fit();
+            clampPan();
+            uploadsThisFrame = 0;
+
+            ImVec2 clipMax(origin.x + size.x, origin.y + size.y);
+            dl->PushClipRect(origin, clipMax, true);
+
+            // Coarse single-tile overview underneath so missing detail tiles never show holes
+            int coarse = coarsestLevel();
+            drawLevel(dl, coarse);
+            int lvl = levelForZoom();
+            if (lvl < coarse) drawLevel(dl, lvl);
+
+            dl->PopClipRect();
+            evict();
+        }
+
+        void releaseTextures() {
+            for (auto& kv : tiles)
+                if (kv.second.tex) glDeleteTextures(1, &kv.second.tex);
+            tiles.clear();
+            lru.clear();
+        }
+
+    private:
+        struct Tile {
+            GLuint tex = 0;
+            list<uint64_t>::iterator lruIt;
+        };
+
+        vector<Mat> pyramid;
+        unordered_map<uint64_t, Tile> tiles;
+        list<uint64_t> lru; // front = most recently drawn
+        float zoomFactor = 1.0f;
+        Point2f pan; // original-image coordinate shown at viewOrigin
+        ImVec2 viewOrigin, viewSize;
+        bool needsFit = true;
+        bool panning = false;
+        int uploadsThisFrame = 0;
+
+        const Mat& base() const { return pyramid[0]; }
+
+        static uint64_t tileKey(int level, int tx, int ty) {
+            return ((uint64_t)level << 48) | ((uint64_t)(uint32_t)ty << 24) | (uint64_t)(uint32_t)tx;
+        }
+
+        const Mat& level(int l) {
+            while ((int)pyramid.size() <= l) {
+                const Mat& prev = pyramid.back();
+                Mat next;
+                resize(prev, next, Size(max(1, (prev.cols + 1) / 2), max(1, (prev.rows + 1) / 2)), 0, 0, INTER_AREA);
+                pyramid.push_back(next);
+            }
+            return pyramid[l];
+        }
+
+        int coarsestLevel() const {
+            int l = 0, w = base().cols, h = base().rows;
+            while (w > kTileSize || h > kTileSize) {
+                w = max(1, (w + 1) / 2);
+                h = max(1, (h + 1) / 2);
+                ++l;
+            }
+            return l;
+        }
+
+        int levelForZoom() const {
+            if (zoomFactor >= 1.0f) return 0;
+            int l = (int)floor(log2(1.0f / zoomFactor));
+            return std::max(0, std::min(l, coarsestLevel()));
+        }
+
+        float minZoom() const {
+            float fitZoom = std::min(viewSize.x / base().cols, viewSize.y / base().rows);
+            return std::min(fitZoom, 1.0f) * 0.5f;
+        }
+
+        void fit() {
+            float z = std::min(viewSize.x / base().cols, viewSize.y / base().rows);
+            zoomFactor = z > 0 ? z : 1.0f;
+            needsFit = false;
+            // center
+            pan.x = (base().cols - viewSize.x / zoomFactor) * 0.5f;
+            pan.y = (base().rows - viewSize.y / zoomFactor) * 0.5f;
+        }
+
+        void clampPan() {
+            if (empty() || zoomFactor <= 0) return;
+            float visW = viewSize.x / zoomFactor, visH = viewSize.y / zoomFactor;
+            // keep the image centered along an axis where it fits entirely
+            if (visW >= base().cols) pan.x = (base().cols - visW) * 0.5f;
+            else pan.x = std::max(0.0f, std::min(pan.x, base().cols - visW));
+            if (visH >= base().rows) pan.y = (base().rows - visH) * 0.5f;
+            else pan.y = std::max(0.0f, std::min(pan.y, base().rows - visH));
+        }
+
+        void drawLevel(ImDrawList* dl, int l) {
+            const Mat& lv = level(l);
+            float sx = (float)base().cols / lv.cols;
+            float sy = (float)base().rows / lv.rows;
+
+            Point2f tl = screenToImage(viewOrigin);
+            Point2f br = screenToImage(ImVec2(viewOrigin.x + viewSize.x, viewOrigin.y + viewSize.y));
+            int tx0 = std::max(0, (int)floor(tl.x / sx / kTileSize));
+            int ty0 = std::max(0, (int)floor(tl.y / sy / kTileSize));
+            int tx1 = std::min((lv.cols - 1) / kTileSize, (int)floor(br.x / sx / kTileSize));
+            int ty1 = std::min((lv.rows - 1) / kTileSize, (int)floor(br.y / sy / kTileSize));
+
+            for (int ty = ty0; ty <= ty1; ++ty) {
+                for (int tx = tx0; tx <= tx1; ++tx) {
+                    GLuint tex = tileTexture(l, tx, ty, lv);
+                    if (!tex) continue;
+                    Rect r(tx * kTileSize, ty * kTileSize,
+                        std::min(kTileSize, lv.cols - tx * kTileSize),
+                        std::min(kTileSize, lv.rows - ty * kTileSize));
+                    ImVec2 a = imageToScreen(Point2f(r.x * sx, r.y * sy));
+                    ImVec2 b = imageToScreen(Point2f((r.x + r.width) * sx, (r.y + r.height) * sy));
+                    dl->AddImage((ImTextureID)(intptr_t)tex, a, b);
+                }
+            }
+        }
+
+        GLuint tileTexture(int l, int tx, int ty, const Mat& lv) {
+            uint64_t key = tileKey(l, tx, ty);
+            auto it = tiles.find(key);
+            if (it != tiles.end()) {
+                lru.splice(lru.begin(), lru, it->second.lruIt);
+                return it->second.tex;
+            }
+            if (uploadsThisFrame >= maxUploadsPerFrame) return 0;
+            ++uploadsThisFrame;
+
+            Rect r(tx * kTileSize, ty * kTileSize,
+                std::min(kTileSize, lv.cols - tx * kTileSize),
+                std::min(kTileSize, lv.rows - ty * kTileSize));
+            Tile t;
+            t.tex = matToTexture(lv(r));
+            lru.push_front(key);
+            t.lruIt = lru.begin();
+            tiles[key] = t;
+            return t.tex;
+        }
+
+        void evict() {
+            while (tiles.size() > maxTiles && !lru.empty()) {
+                uint64_t key = lru.back();
+                lru.pop_back();
+                auto it = tiles.find(key);
+                if (it != tiles.end()) {
+                    if (it->second.tex) glDeleteTextures(1, &it->second.tex);
+                    tiles.erase(it);
+                }
+            }
+        }
+    };
+
+} // namespace DocScanner
@@ -0,0 +1,137 @@
+// Trace.hpp
+#pragma once
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace DocScanner {
+
+    // Collects complete ("ph":"X") events for the Chrome trace / Perfetto JSON format.
+    // Events are buffered per thread and only merged in write(); each buffer has its
+    // own lock, which only write() ever competes for, so recording stays uncontended.
+    // A buffer keeps the newest kMaxEventsPerThread events (a ring), so long live
+    // sessions do not grow without bound. Disabled by default; fed by the same
+    // DS_PROFILE_SCOPE markers as the Profiler.
+    class Tracer {
+    public:
+        typedef chrono::steady_clock Clock;
+        static const size_t kMaxEventsPerThread = 1 << 18;
+
+        struct Event {
+            const char* name;
+            long long tsUs, durUs;
+            string tag;
+        };
+
+        static Tracer& instance() {
+            static Tracer t;
+            return t;
+        }
+
+        static bool enabled() { return instance().on.load(memory_order_relaxed); }
+        void setEnabled(bool e) { on.store(e, memory_order_relaxed); }
+
+        void add(const char* name, Clock::time_point start, Clock::time_point end) {
+            ThreadBuffer& b = threadBuffer();
+            Event ev;
+            ev.name = name;
+            ev.tsUs = chrono::duration_cast<chrono::microseconds>(start - epoch).count();
+            ev.durUs = chrono::duration_cast<chrono::microseconds>(end - start).count();
+            ev.tag = currentTag();
+            lock_guard<mutex> lk(b.mtx);
+            if (b.events.size() < kMaxEventsPerThread) b.events.push_back(ev);
+            else {
+                b.events[b.next] = ev;
+                b.next = (b.next + 1) % kMaxEventsPerThread;
+                ++b.dropped;
+            }
+        }
+
+        // Per-thread label attached to every event (e.g. the image being processed).
+        static string& currentTag() {
+            static thread_local string tag;
+            return tag;
+        }
+
+        // Name shown for the calling thread in the trace viewer.
+        void setThreadName(const string& name) {
+            ThreadBuffer& b = threadBuffer();
+            lock_guard<mutex> lk(b.mtx);
+            b.name = name;
+        }
+
+        bool write(const string& path) {
+            FileStorage fs(path, FileStorage::WRITE | FileStorage::FORMAT_JSON);
+            if (!fs.isOpened()) return false;
+            lock_guard<mutex> lk(mtx);
+            fs << "displayTimeUnit" << "ms";
+            unsigned long long dropped = 0;
+            fs << "traceEvents" << "[";
+            for (auto& b : buffers) {
+                lock_guard<mutex> blk(b->mtx);
+                dropped += b->dropped;
+                if (!b->name.empty()) {
+                    fs << "{" << "name" << "thread_name" << "ph" << "M" << "pid" << 1 << "tid" << b->tid;
+                    fs << "args" << "{" << "name" << b->name << "}";
+                    fs << "}";
+                }
+                for (auto& e : b->events) {
+                    fs << "{";
+                    fs << "name" << e.name << "cat" << "pipeline" << "ph" << "X";
+                    fs << "ts" << (double)e.tsUs << "dur" << (double)e.durUs;
+                    fs << "pid" << 1 << "tid" << b->tid;
+                    if (!e.tag.empty()) fs << "args" << "{" << "image" << e.tag << "}";
+                    fs << "}";
+                }
+            }
+            fs << "]";
+            if (dropped) fs << "otherData" << "{" << "dropped_events" << (double)dropped << "}";
+            return true;
+        }
+
+    private:
+        struct ThreadBuffer {
+            int tid = 0;
+            string name;
+            vector<Event> events;
+            size_t next = 0;                // oldest event once the ring is full
+            unsigned long long dropped = 0; // overwritten oldest events
+            mutex mtx;
+        };
+
+        atomic<bool> on{ false };
+        Clock::time_point epoch = Clock::now();
+        mutex mtx;
+        vector<shared_ptr<ThreadBuffer>> buffers; // outlive their threads
+
+        ThreadBuffer& threadBuffer() {
+            static thread_local ThreadBuffer* local = nullptr;
+            if (!local) {
+                auto b = make_shared<ThreadBuffer>();
+                lock_guard<mutex> lk(mtx);
+                b->tid = (int)buffers.size() + 1;
+                buffers.push_back(b);
+                local = b.get();
+            }
+            return *local;
+        }
+    };
+
+    // Sets the trace tag of the current thread for the lifetime of the scope.
+    class ScopedTraceTag {
+    public:
+        explicit ScopedTraceTag(const string& tag) : prev(Tracer::currentTag()) { Tracer::currentTag() = tag; }
+        ~ScopedTraceTag() { Tracer::currentTag() = prev; }
+
+    private:
+        string prev;
+    };
+
+} // namespace DocScanner
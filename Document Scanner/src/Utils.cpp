@@ -0,0 +1,51 @@
+// Utils.cpp
+#include "Utils.hpp"
+#include <cstdio>
+#include <sys/stat.h>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace DocScanner {
+
+    bool replaceFile(const string& from, const string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return rename(from.c_str(), to.c_str()) == 0; // POSIX rename replaces atomically
+#endif
+    }
+
+    bool fileStatus(const string& path, long long& size, long long& mtimeNs) {
+#ifdef _WIN32
+        int n = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+        if (n <= 0) return false;
+        wstring wpath(n, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wpath[0], n);
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &data)) return false;
+        size = (long long)(((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow);
+        long long ticks = (long long)(((unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime);
+        mtimeNs = (ticks - 116444736000000000LL) * 100; // 100 ns ticks since 1601-01-01
+#else
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return false;
+        size = (long long)st.st_size;
+#if defined(__linux__)
+        mtimeNs = (long long)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+        mtimeNs = (long long)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+        mtimeNs = (long long)st.st_mtime * 1000000000;
+#endif
+#endif
+        return true;
+    }
+
+} // namespace DocScanner
@@ -0,0 +1,21 @@
+// Utils.hpp
+#pragma once
+#include <string>
+
+using namespace std;
+
+namespace DocScanner {
+
+    // Platform file-system calls, defined in Utils.cpp so that <windows.h> and
+    // its macros stay out of every file that includes this one.
+
+    // Moves from over to, replacing an existing file in one step (the CRT's
+    // rename() on Windows refuses to replace). False if to was left as it was.
+    bool replaceFile(const string& from, const string& to);
+
+    // Size in bytes and last write time in nanoseconds since the Unix epoch, at
+    // the resolution the file system keeps (the same source as the image
+    // picker's listing cache). path is UTF-8.
+    bool fileStatus(const string& path, long long& size, long long& mtimeNs);
+
+} // namespace DocScanner
@@ -1,85 +1,273 @@
 ﻿#include <opencv2/opencv.hpp>
+#include <opencv2/core/utils/filesystem.hpp>
 #include <GLFW/glfw3.h>
 #include "imgui/imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 #include "Core.hpp"
+#include "TiledViewer.hpp"
+#include "ProfilerPanel.hpp"
+#include "Batch.hpp"
+#include "LiveScanner.hpp"
+#include "MultiDoc.hpp"
+#include "Enhance.hpp"
+#include "Session.hpp"
+#include "Thumbnails.hpp"
 #include "imgui/ImGuiFileDialog.h"
+#include "imgui/imgui_stdlib.h"
 
 using namespace cv;
 using namespace std;
 using namespace DocScanner;
 
 struct AppState {
-    Mat imgOrig, preview;
+    Mat imgOrig;
     Mat warpedBW, warpedColor;
+    Mat warpedEnhanced;       // magic colour / enhanced grey version of warpedColor
+    EnhanceMode enhanceMode = EnhanceMode::MagicColor;
+    int previewKind = 0;      // 0 = colour, 1 = BW, 2 = enhanced
     vector<Point2f> autoPts, manualPts;
     bool manualMode = false;
     bool foundAuto = false;
     int dragIdx = -1; // index of currently dragged point
-    float scale = 1.0f;
+    DetectorMethod detector = DetectorMethod::Contour;
+    BinarizeMethod binarizeMethod = BinarizeMethod::Adaptive;
+    double confidence = 0;    // of the automatic detection
+    string detectorUsed;
     string filename = "";
+    string sourcePath;        // file imgOrig was read from; empty for live frames
+    vector<Point2f> warpQuad; // quad of the current warp, TL, TR, BR, BL
+    int page = -1;            // session page being shown, -1 if not in the session
+    // Multi-document mode: every detected document, its scans, and the one shown
+    bool multiDoc = false;
+    vector<vector<Point2f>> docQuads;
+    vector<ScannedDoc> docs;
+    int docIdx = 0;
 } app;
 
-// --- Helper: Convert cv::Mat -> OpenGL Texture
-GLuint matToTexture(const Mat& mat) {
-    if (mat.empty()) return 0;
-    Mat rgb;
-    if (mat.channels() == 1)
-        cvtColor(mat, rgb, COLOR_GRAY2RGB);
-    else
-        cvtColor(mat, rgb, COLOR_BGR2RGB);
+TiledViewer viewer;
+ThumbnailCache thumbnails; // for the image picker
+ResultCache resultCache;   // detections of files opened before
+
+// Call whenever warpedColor changes
+void updateEnhanced() {
+    app.warpedEnhanced = app.warpedColor.empty() ? Mat() : enhance(app.warpedColor, app.enhanceMode);
+}
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+// Fixed capture rig: warp maps reused while the quad stays put
+bool useRig = false;
+WarpMapCache rigCache;
+
+// Live scanning from a camera index or video file
+struct LiveState {
+    FrameGrabber grabber;
+    QuadTracker tracker;
+    AutoCapture autoCapture;
+    bool autoEnabled = true;
+    int captures = 0;
+    bool running = false;
+    string source = "0";
+} live;
+
+void stopLive() {
+    live.grabber.close();
+    live.autoCapture.wait(); // nothing may still record trace events once the trace is written
+    live.running = false;
+}
 
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, rgb.cols, rgb.rows, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb.data);
-    return tex;
+bool startLive(const string& source) {
+    stopLive();
+    if (!live.grabber.open(source)) {
+        cerr << "Cannot open video source " << source << endl;
+        return false;
+    }
+    live.tracker.reset();
+    live.autoCapture.reset();
+    live.captures = 0;
+    live.running = true;
+    app.filename = "live: " + source;
+    app.sourcePath.clear();
+    app.page = -1;
+    app.manualPts.clear();
+    app.docQuads.clear();
+    app.docs.clear();
+    app.warpedBW.release();
+    app.warpedColor.release();
+    app.warpedEnhanced.release();
+    return true;
+}
+
+// Pages scanned so far; full-resolution buffers spill to disk past the budget
+Session session;
+int sessionBudgetMB = 512;
+bool captureToSession = true;
+
+void addToSession() {
+    if (app.warpedColor.empty() || app.imgOrig.empty()) return;
+    if (app.page >= 0) { // re-warped a page from the session
+        session.updateResults(app.page, app.warpQuad, app.warpedColor, app.warpedBW);
+        return;
+    }
+    string name = app.filename.substr(app.filename.find_last_of("/\\") + 1);
+    if (app.docs.size() > 1) name += " #" + to_string(app.docIdx + 1);
+    app.page = session.addPage(name, app.imgOrig, app.sourcePath, app.warpQuad, app.warpedColor, app.warpedBW);
 }
 
-// --- Compute scaled preview
-void computeScaledPreviewToFit(int maxW, int maxH) {
-    if (app.imgOrig.empty()) {
-        app.preview.release();
-        app.scale = 1.0f;
+// --- Show a session page again, reading it back from disk if it was spilled
+void openPage(int i) {
+    if (live.running) stopLive();
+    Mat orig, color, bw;
+    if (!session.load(i, orig, color, bw)) {
+        cerr << "Cannot reload session page " << i + 1 << endl;
         return;
     }
-    if (maxW <= 0) maxW = 1;
-    if (maxH <= 0) maxH = 1;
-    double sx = (double)maxW / app.imgOrig.cols;
-    double sy = (double)maxH / app.imgOrig.rows;
-    app.scale = (float)min(sx, sy);
-    Size dstSz((int)round(app.imgOrig.cols * app.scale), (int)round(app.imgOrig.rows * app.scale));
-    if (dstSz.width <= 0) dstSz.width = 1;
-    if (dstSz.height <= 0) dstSz.height = 1;
-    resize(app.imgOrig, app.preview, dstSz);
+    const SessionPage& p = session.page(i);
+    app.page = i;
+    app.filename = p.name;
+    app.sourcePath.clear();
+    app.imgOrig = orig;
+    viewer.setImage(app.imgOrig);
+    app.docQuads.clear();
+    app.docs.clear();
+    app.manualPts.clear();
+    app.foundAuto = p.quad.size() == 4;
+    app.autoPts = p.quad;
+    app.warpQuad = p.quad;
+    app.detectorUsed.clear();
+    app.warpedColor = color;
+    app.warpedBW = bw;
+    updateEnhanced();
+}
+
+void removePage(int i) {
+    session.removePage(i);
+    if (app.page == i) app.page = -1;
+    else if (app.page > i) --app.page;
+}
+
+// --- Take the newest frame (if any) and move the quad along with the page
+void pollLive() {
+    // a shot started before Stop still lands in the preview
+    Mat shotFrame;
+    if (live.autoCapture.fetch(app.warpedColor, app.warpedBW, &shotFrame, &app.warpQuad)) {
+        ++live.captures;
+        updateEnhanced();
+        if (captureToSession)
+            session.addPage("capture " + to_string(live.captures), shotFrame, "", app.warpQuad,
+                app.warpedColor, app.warpedBW);
+    }
+    if (!live.running) return;
+    LiveFrame lf;
+    if (!live.grabber.take(lf)) {
+        if (live.grabber.finished()) stopLive(); // end of file or camera unplugged; keep the last frame
+        return;
+    }
+    DS_PROFILE_SCOPE("liveFrame");
+    const Mat& frame = lf.image;
+    app.imgOrig = frame;
+    viewer.setImage(app.imgOrig, true);
+    app.foundAuto = live.tracker.update(frame);
+    app.autoPts = app.foundAuto ? live.tracker.quad() : vector<Point2f>();
+
+    if (live.autoEnabled && !app.manualMode) live.autoCapture.update(frame, app.autoPts);
+    live.grabber.frameDone(lf);
+}
+
+// --- Automatic page detection on the current still image
+void detectAuto() {
+    app.docs.clear();
+    app.page = -1;
+    if (app.multiDoc) {
+        app.docQuads = findDocuments(app.imgOrig);
+        app.foundAuto = !app.docQuads.empty();
+        app.autoPts = app.foundAuto ? app.docQuads[0] : vector<Point2f>();
+        return;
+    }
+    app.docQuads.clear();
+    Detection d = detect(app.imgOrig, app.detector);
+    app.foundAuto = d.found;
+    app.autoPts = d.quad;
+    app.confidence = d.confidence;
+    app.detectorUsed = d.detector;
+    if (app.foundAuto)
+        app.autoPts = reorderPoints(app.autoPts);
+    else
+        app.autoPts.clear();
+}
+
+void showDoc(int i) {
+    if (app.docs.empty()) return;
+    app.docIdx = (i + (int)app.docs.size()) % (int)app.docs.size();
+    app.warpQuad = app.docs[app.docIdx].quad;
+    app.page = -1;
+    app.warpedColor = app.docs[app.docIdx].color;
+    app.warpedBW = app.docs[app.docIdx].bw;
+    updateEnhanced();
 }
 
 // --- Load image and detect automatic document contour
 bool loadImage(const string& path) {
-    Mat img = imread(path, IMREAD_COLOR);
+    DS_PROFILE_SCOPE("loadImage");
+    stopLive();
+    Mat img;
+    string cacheKey;
+    {
+        DS_PROFILE_SCOPE("imread");
+        vector<uchar> bytes;
+        if (resultCache.enabled() && readFileBytes(path, bytes)) {
+            cacheKey = resultCache.key(bytes, detectionSettings(app.detector, app.multiDoc));
+            img = imdecode(bytes, IMREAD_COLOR);
+        }
+        else img = imread(path, IMREAD_COLOR);
+    }
     if (img.empty()) {
         cerr << "Cannot open " << path << endl;
         return false;
     }
     app.imgOrig = img;
-
-    Mat pre = preProcessForContours(app.imgOrig);
-    app.foundAuto = findDocumentContour(pre, app.autoPts);
-    if (app.foundAuto)
-        app.autoPts = reorderPoints(app.autoPts);
+    app.sourcePath = path;
+    viewer.setImage(app.imgOrig);
+
+    // A file opened before gets its quads back instead of running detection
+    ResultCache::Entry cached;
+    if (!cacheKey.empty() && resultCache.find(cacheKey, cached) && !cached.quads.empty()) {
+        app.docs.clear();
+        app.page = -1;
+        app.foundAuto = cached.foundAuto;
+        app.confidence = cached.confidence;
+        app.detectorUsed = cached.detector;
+        app.docQuads.clear();
+        if (app.multiDoc && app.foundAuto) app.docQuads = cached.quads;
+        app.autoPts = app.foundAuto ? cached.quads[0] : vector<Point2f>();
+    }
+    else {
+        detectAuto();
+        if (!cacheKey.empty()) {
+            ResultCache::Entry e;
+            e.foundAuto = app.foundAuto;
+            e.confidence = app.confidence;
+            e.detector = app.foundAuto && !app.multiDoc ? app.detectorUsed : string();
+            if (app.multiDoc && app.foundAuto) e.quads = app.docQuads;
+            else e.quads.push_back(app.foundAuto ? app.autoPts : fullFrame(app.imgOrig));
+            resultCache.store(cacheKey, e);
+        }
+    }
     app.manualPts.clear();
     app.warpedBW.release();
     app.warpedColor.release();
+    app.warpedEnhanced.release();
     return true;
 }
 
 // --- Warp document using current points
 void doWarp() {
+    DS_PROFILE_SCOPE("doWarp");
+    if (app.multiDoc && !app.manualMode && !app.docQuads.empty() && !live.running) {
+        app.docs = scanDocuments(app.imgOrig, app.docQuads, app.binarizeMethod);
+        showDoc(0);
+        return;
+    }
+    app.docs.clear();
     vector<Point2f> usePts;
     if (app.manualMode && app.manualPts.size() == 4)
         usePts = app.manualPts;
@@ -90,17 +278,51 @@ void doWarp() {
         return;
     }
     auto ordered = reorderPoints(usePts);
-    Mat warped = getWarpedA4(app.imgOrig, ordered);
+    app.warpQuad = ordered;
+    Mat warped = useRig ? getWarpedA4Cached(rigCache, app.imgOrig, ordered) : getWarpedA4(app.imgOrig, ordered);
     app.warpedColor = warped.clone();
-    app.warpedBW = makeBWScanEffect(warped);
+    app.warpedBW = binarize(warped, app.binarizeMethod);
+    updateEnhanced();
 }
 
 // --- Main
 int main(int argc, char** argv) {
+    BatchOptions cli;
+    if (!parseCommandLine(argc, argv, cli)) {
+        printBatchUsage();
+        return 1;
+    }
+    if (!cli.tracePath.empty()) {
+        Tracer::instance().setEnabled(true);
+        Tracer::instance().setThreadName("main");
+    }
+    if (cli.enabled) {
+        int rc = runBatch(cli);
+        if (!cli.tracePath.empty() && !Tracer::instance().write(cli.tracePath))
+            cerr << "Cannot write trace " << cli.tracePath << endl;
+        return rc;
+    }
+
+    app.detector = cli.detector;
+    useRig = cli.rig;
+    app.binarizeMethod = cli.binarize;
+    live.autoCapture.setBinarize(app.binarizeMethod);
+    if (!cli.calibPath.empty()) {
+        LensCalibration lens;
+        if (loadCalibration(cli.calibPath, lens)) rigCache.setLens(lens);
+        else cerr << "Cannot read calibration " << cli.calibPath << endl;
+    }
+    live.tracker.setDetector(app.detector);
+    if (!cli.cacheDir.empty()) resultCache.open(cli.cacheDir + "/results");
+
     // start without preloaded image
-    if (argc > 1) {
+    if (!cli.liveSource.empty()) {
+        live.source = cli.liveSource;
+        startLive(live.source);
+    }
+    else if (!cli.inputs.empty()) {
         // if user passed path on cmdline, try to load it
-        app.filename = argv[1];
+        app.filename = cli.inputs[0];
         if (!loadImage(app.filename)) {
             app.filename.clear();
         }
@@ -123,17 +345,49 @@ int main(int argc, char** argv) {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 130");
 
-    GLuint texPreview = 0, texWarped = 0;
+    // Thumbnails list of the picker: only the rows on screen are asked for
+    ImGuiFileDialog::Instance()->SetRequestThumbnailCallback([](const std::string& path, IGFD_Thumbnail_Info* th) {
+        ImVec2 uv0, uv1, size;
+        th->isReadyToDisplay = thumbnails.lookup(path, uv0, uv1, size);
+        if (!th->isReadyToDisplay) return;
+        th->textureID = (void*)(intptr_t)thumbnails.texture();
+        th->textureWidth = (int)size.x;
+        th->textureHeight = (int)size.y;
+        th->uv0[0] = uv0.x; th->uv0[1] = uv0.y;
+        th->uv1[0] = uv1.x; th->uv1[1] = uv1.y;
+    });
+
+    // Listings and thumbnails of folders seen in earlier runs: reopening a big
+    // inbox costs one directory time check instead of a stat and decode per file
+    string listingCacheFile;
+    if (!cli.cacheDir.empty() && utils::fs::createDirectories(cli.cacheDir + "/thumbs")) {
+        thumbnails.setCacheDir(cli.cacheDir + "/thumbs");
+        listingCacheFile = cli.cacheDir + "/listings.txt";
+        ifstream in(listingCacheFile, ios::binary);
+        if (in) {
+            stringstream ss;
+            ss << in.rdbuf();
+            ImGuiFileDialog::Instance()->DeserializeListingCache(ss.str());
+        }
+    }
+
+    GLuint texWarped = 0;
+    GLuint texPagePreview = 0;   // tooltip preview of a session page
+    int texPagePreviewIdx = -1;
     string lastPreviewHash = "";
     string lastWarpedHash = "";
     int themeIndex = 0; // 0 = Light, 1 = Dark
+    bool showProfiler = false;
 
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
+        Profiler::instance().beginFrame();
+        pollLive();
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
+        thumbnails.newFrame();
 
         // ===== Get window dimensions (put it here) =====
         int display_w, display_h;
@@ -221,6 +475,23 @@ int main(int argc, char** argv) {
                 config
             );
         }
+
+        if (ImGui::Button("Save Enhanced") && !app.warpedEnhanced.empty()) {
+            IGFD::FileDialogConfig config;
+            config.path = ".";
+            config.countSelectionMax = 1;
+            config.flags = ImGuiFileDialogFlags_Modal;
+
+            // set minimum initial window size (user can still resize)
+            ImGui::SetNextWindowSize(ImVec2(900, 600), ImGuiCond_Appearing);
+
+            ImGuiFileDialog::Instance()->OpenDialog(
+                "SaveEnhancedDialog",
+                "Save Enhanced Image As...",
+                "PNG files{.png},JPEG files{.jpg,.jpeg},Bitmap files{.bmp},All files{.*}",
+                config
+            );
+        }
         // --- Save dialogs handling ---
         if (ImGuiFileDialog::Instance()->Display("SaveBWDialog")) {
             if (ImGuiFileDialog::Instance()->IsOk()) {
@@ -250,6 +521,20 @@ int main(int argc, char** argv) {
             ImGuiFileDialog::Instance()->Close();
         }
 
+        if (ImGuiFileDialog::Instance()->Display("SaveEnhancedDialog")) {
+            if (ImGuiFileDialog::Instance()->IsOk()) {
+                std::string savePath = ImGuiFileDialog::Instance()->GetFilePathName();
+                try {
+                    imwrite(savePath, app.warpedEnhanced);
+                    cout << "Saved enhanced image to: " << savePath << endl;
+                }
+                catch (const cv::Exception& e) {
+                    cerr << "Failed to save enhanced image: " << e.what() << endl;
+                }
+            }
+            ImGuiFileDialog::Instance()->Close();
+        }
+
         ImGui::Separator();
         ImGui::Text("Theme");
 
@@ -260,6 +545,43 @@ int main(int argc, char** argv) {
             else
                 ImGui::StyleColorsDark();
         }
+
+        ImGui::Text("Detector");
+        int detectorIndex = (int)app.detector;
+        const char* detectors[] = { "Contour", "Line segments", "Cascade" };
+        if (ImGui::Combo("##DetectorCombo", &detectorIndex, detectors, IM_ARRAYSIZE(detectors))) {
+            app.detector = (DetectorMethod)detectorIndex;
+            live.tracker.setDetector(app.detector);
+            if (!live.running && !app.imgOrig.empty()) detectAuto();
+        }
+        ImGui::Text("Binarization");
+        int binarizeIndex = (int)app.binarizeMethod;
+        const char* binarizers[] = { "Adaptive (CLAHE)", "Normalized lighting" };
+        if (ImGui::Combo("##BinarizeCombo", &binarizeIndex, binarizers, IM_ARRAYSIZE(binarizers))) {
+            app.binarizeMethod = (BinarizeMethod)binarizeIndex;
+            live.autoCapture.setBinarize(app.binarizeMethod);
+            if (!app.warpedColor.empty() && app.docs.empty())
+                app.warpedBW = binarize(app.warpedColor, app.binarizeMethod);
+            for (auto& d : app.docs) d.bw = binarize(d.color, app.binarizeMethod);
+            showDoc(app.docIdx);
+        }
+        ImGui::Text("Enhanced output");
+        int enhanceIndex = app.enhanceMode == EnhanceMode::Gray ? 1 : 0;
+        const char* enhancers[] = { "Magic colour", "Enhanced grey" };
+        if (ImGui::Combo("##EnhanceCombo", &enhanceIndex, enhancers, IM_ARRAYSIZE(enhancers))) {
+            app.enhanceMode = enhanceIndex == 1 ? EnhanceMode::Gray : EnhanceMode::MagicColor;
+            updateEnhanced();
+        }
+        if (ImGui::Checkbox("Multiple documents", &app.multiDoc) && !live.running && !app.imgOrig.empty())
+            detectAuto();
+        if (app.multiDoc && !live.running)
+            ImGui::Text("Documents found: %d", (int)app.docQuads.size());
+        else if (app.foundAuto && !live.running && app.detectorUsed.empty() && app.page >= 0)
+            ImGui::Text("Session page %d (saved quad)", app.page + 1);
+        else if (app.foundAuto && !live.running)
+            ImGui::Text("Confidence: %.2f (%s)", app.confidence, app.detectorUsed.c_str());
+        else if (!app.imgOrig.empty() && !live.running)
+            ImGui::Text("No page detected");
         ImGui::Separator();
 
         bool oldMode = app.manualMode;
@@ -274,6 +596,74 @@ int main(int argc, char** argv) {
             app.manualPts.clear();
         }
 
+        ImGui::Separator();
+        ImGui::Text("Live (camera index or video file)");
+        ImGui::InputText("##LiveSource", &live.source);
+        ImGui::SameLine();
+        if (!live.running) {
+            if (ImGui::Button("Start")) startLive(live.source);
+        }
+        else if (ImGui::Button("Stop")) stopLive();
+        if (live.running)
+            ImGui::Text("Tracking: %s  conf %.2f%s", app.foundAuto ? "yes" : "no",
+                live.tracker.confidence(), live.tracker.lastWasKeyframe() ? "  [keyframe]" : "");
+        if (live.running)
+            ImGui::Text("Frames %llu  dropped %llu  latency %.1f ms (avg %.1f)", live.grabber.grabbed(),
+                live.grabber.dropped(), live.grabber.lastLatency(), live.grabber.avgLatency());
+        ImGui::Checkbox("Auto capture", &live.autoEnabled);
+        if (live.running && live.autoEnabled) {
+            const AutoCapture& ac = live.autoCapture;
+            ImGui::Text("Steady %d/%d  sharp %.0f  shots %d%s", min(ac.steadyFrames(), ac.options().stableFrames),
+                ac.options().stableFrames, ac.lastSharpness(), live.captures,
+                ac.busy() ? "  [scanning]" : (ac.isArmed() ? "" : "  [move to re-arm]"));
+        }
+
+        ImGui::Checkbox("Fixed rig (cached warp)", &useRig);
+        if (useRig)
+            ImGui::Text("Maps built %llu, reused %llu%s", rigCache.misses(), rigCache.hits(),
+                rigCache.hasLens() ? "  [lens]" : "");
+
+        ImGui::Separator();
+        ImGui::Text("Session: %d pages", session.size());
+        if (ImGui::Button(app.page >= 0 ? "Update Page" : "Add to Session")) addToSession();
+        ImGui::SameLine();
+        if (ImGui::Button("Remove Page") && app.page >= 0) {
+            removePage(app.page);
+            texPagePreviewIdx = -1;
+        }
+        ImGui::Checkbox("Add auto captures", &captureToSession);
+        if (ImGui::SliderInt("RAM (MB)", &sessionBudgetMB, 64, 4096))
+            session.setBudget((size_t)sessionBudgetMB << 20);
+        ImGui::Text("Resident %.0f MB  spilled %llu  reloaded %llu", session.residentBytes() / 1048576.0,
+            session.spills(), session.reloads());
+        ImGui::BeginChild("##Pages", ImVec2(0, 120), true);
+        for (int i = 0; i < session.size(); ++i) {
+            const SessionPage& p = session.page(i);
+            string label = to_string(i + 1) + ". " + p.name + (session.isResident(i) ? "" : "  [disk]")
+                + "##page" + to_string(i);
+            if (ImGui::Selectable(label.c_str(), app.page == i)) openPage(i);
+            if (ImGui::IsItemHovered() && !p.preview.empty()) {
+                if (texPagePreviewIdx != i) { // previews are always resident: no disk access on hover
+                    if (texPagePreview) glDeleteTextures(1, &texPagePreview);
+                    texPagePreview = matToTexture(p.preview);
+                    texPagePreviewIdx = i;
+                }
+                ImGui::BeginTooltip();
+                ImGui::Image((ImTextureID)(intptr_t)texPagePreview, ImVec2((float)p.preview.cols, (float)p.preview.rows));
+                ImGui::EndTooltip();
+            }
+        }
+        ImGui::EndChild();
+
+        ImGui::Separator();
+        if (ImGui::Button("Fit View")) viewer.requestFit();
+        ImGui::SameLine();
+        ImGui::Text("Zoom: %.0f%%", viewer.zoom() * 100.0f);
+
+        ImGui::Separator();
+        if (ImGui::Checkbox("Profiler", &showProfiler))
+            Profiler::instance().setEnabled(showProfiler);
+
         ImGui::End();
 
         // ==== Image View ====
@@ -286,57 +676,41 @@ int main(int argc, char** argv) {
             ImGuiWindowFlags_NoScrollbar |
             ImGuiWindowFlags_NoScrollWithMouse);
 
-        // Determine available size inside Image View to fit the image
+        // Determine available size inside Image View
         ImVec2 avail = ImGui::GetContentRegionAvail();
         int availW = (int)avail.x;
         int availH = (int)avail.y;
 
-        // compute preview sized to fit avail area
-        computeScaledPreviewToFit(availW, availH);
-
-        ImVec2 imgStart = ImGui::GetCursorScreenPos();
-        ImVec2 imgSize((float)app.preview.cols, (float)app.preview.rows);
-
         // draw placeholder if no image
-        if (app.preview.empty()) {
+        if (viewer.empty()) {
             ImGui::Dummy(ImVec2((float)min(availW, 400), (float)min(availH, 300)));
             ImGui::SameLine();
             ImGui::TextWrapped("No image loaded.\nClick 'Load Image...' to open an image.");
         }
         else {
-            // ensure texture updated for preview
-            if (texPreview) { glDeleteTextures(1, &texPreview); texPreview = 0; }
-            texPreview = matToTexture(app.preview);
+            ImVec2 viewStart = ImGui::GetCursorScreenPos();
+            if (avail.x < 1) avail.x = 1;
+            if (avail.y < 1) avail.y = 1;
 
-            // center the image inside the available region horizontally/vertically
-            ImVec2 curCursor = ImGui::GetCursorScreenPos();
-            float padX = (avail.x - imgSize.x) * 0.5f;
-            float padY = (avail.y - imgSize.y) * 0.5f;
-            if (padX < 0) padX = 0;
-            if (padY < 0) padY = 0;
-            ImGui::SetCursorScreenPos(ImVec2(curCursor.x + padX, curCursor.y + padY));
-            ImVec2 drawStart = ImGui::GetCursorScreenPos();
+            // Submit the view area as one item so ImGui knows what is hovered
+            ImGui::InvisibleButton("##ImageCanvas", avail,
+                ImGuiButtonFlags_MouseButtonLeft | ImGuiButtonFlags_MouseButtonRight | ImGuiButtonFlags_MouseButtonMiddle);
+            bool viewHovered = ImGui::IsItemHovered();
 
-            ImGui::Image((ImTextureID)(intptr_t)texPreview, imgSize);
-
-            // Submit a dummy to inform ImGui of the item’s size (prevents Dear ImGui warning)
-            ImGui::Dummy(ImVec2(avail.x, avail.y));
-
-            // prepare draw list for overlays
+            // prepare draw list for tiles and overlays
             ImDrawList* draw_list = ImGui::GetWindowDrawList();
-            ImVec2 itemMin = drawStart;
             ImVec2 mousePos = io.MousePos;
 
             // --- Dragging behavior (only when mouse inside image)
+            bool draggingCorner = false;
             if (app.manualMode && !app.manualPts.empty()) {
-                ImVec2 imgMin = itemMin;
-                ImVec2 imgMax(imgMin.x + imgSize.x, imgMin.y + imgSize.y);
-                bool mouseInImage = ImGui::IsMouseHoveringRect(imgMin, imgMax);
+                ImVec2 imgMin, imgMax;
+                viewer.imageScreenRect(imgMin, imgMax);
+                bool mouseInImage = viewHovered && ImGui::IsMouseHoveringRect(imgMin, imgMax);
 
                 if (mouseInImage && ImGui::IsMouseClicked(0)) {
                     for (int i = 0; i < 4; ++i) {
-                        ImVec2 p(itemMin.x + app.manualPts[i].x * app.scale,
-                            itemMin.y + app.manualPts[i].y * app.scale);
+                        ImVec2 p = viewer.imageToScreen(app.manualPts[i]);
                         float dx = mousePos.x - p.x;
                         float dy = mousePos.y - p.y;
                         if ((dx * dx + dy * dy) < 100.0f) {
@@ -346,34 +720,46 @@ int main(int argc, char** argv) {
                     }
                 }
 
-                if (mouseInImage && ImGui::IsMouseDown(0) && app.dragIdx >= 0) {
-                    float x = (mousePos.x - itemMin.x) / app.scale;
-                    float y = (mousePos.y - itemMin.y) / app.scale;
+                if (ImGui::IsMouseDown(0) && app.dragIdx >= 0) {
+                    Point2f p = viewer.screenToImage(mousePos);
                     // clamp to image bounds (original image coordinates)
-                    x = std::max(0.0f, std::min(x, (float)app.imgOrig.cols));
-                    y = std::max(0.0f, std::min(y, (float)app.imgOrig.rows));
-                    app.manualPts[app.dragIdx] = Point2f(x, y);
+                    p.x = std::max(0.0f, std::min(p.x, (float)app.imgOrig.cols));
+                    p.y = std::max(0.0f, std::min(p.y, (float)app.imgOrig.rows));
+                    app.manualPts[app.dragIdx] = p;
                 }
 
                 if (ImGui::IsMouseReleased(0))
                     app.dragIdx = -1;
+                draggingCorner = app.dragIdx >= 0;
             }
 
+            // Wheel zooms, right/middle drag pans (left drag too unless moving a corner)
+            viewer.handleInput(viewHovered, !app.manualMode && !draggingCorner);
+            viewer.draw(draw_list, viewStart, avail);
+
             // --- Draw polygons (use draw_list so overlay is on top)
+            draw_list->PushClipRect(viewStart, ImVec2(viewStart.x + avail.x, viewStart.y + avail.y), true);
             auto drawPoly = [&](const vector<Point2f>& pts, ImU32 color) {
                 if (pts.size() != 4) return;
                 for (int i = 0; i < 4; ++i) {
-                    ImVec2 a(itemMin.x + pts[i].x * app.scale, itemMin.y + pts[i].y * app.scale);
-                    ImVec2 b(itemMin.x + pts[(i + 1) % 4].x * app.scale, itemMin.y + pts[(i + 1) % 4].y * app.scale);
+                    ImVec2 a = viewer.imageToScreen(pts[i]);
+                    ImVec2 b = viewer.imageToScreen(pts[(i + 1) % 4]);
                     draw_list->AddLine(a, b, color, 2.0f);
                     draw_list->AddCircleFilled(a, 6.0f, color);
                 }
                 };
 
-            if (app.foundAuto && !app.manualMode)
+            if (!app.docQuads.empty() && !app.manualMode && !live.running) {
+                for (size_t i = 0; i < app.docQuads.size(); ++i) {
+                    bool shown = !app.docs.empty() && (int)i == app.docIdx;
+                    drawPoly(app.docQuads[i], shown ? IM_COL32(255, 170, 0, 255) : IM_COL32(0, 150, 255, 255));
+                }
+            }
+            else if (app.foundAuto && !app.manualMode)
                 drawPoly(app.autoPts, IM_COL32(0, 150, 255, 255)); // blue auto
             if (app.manualMode && !app.manualPts.empty())
                 drawPoly(app.manualPts, IM_COL32(0, 255, 100, 255)); // green manual
+            draw_list->PopClipRect();
         }
 
         ImGui::End();
@@ -396,17 +782,33 @@ int main(int argc, char** argv) {
             ImGui::TextWrapped("No warped image.\nClick 'Warp' to get a scanned preview.");
         }
         else {
+            if (app.docs.size() > 1) {
+                if (ImGui::ArrowButton("##PrevDoc", ImGuiDir_Left)) showDoc(app.docIdx - 1);
+                ImGui::SameLine();
+                ImGui::Text("Document %d / %d", app.docIdx + 1, (int)app.docs.size());
+                ImGui::SameLine();
+                if (ImGui::ArrowButton("##NextDoc", ImGuiDir_Right)) showDoc(app.docIdx + 1);
+            }
+            ImGui::RadioButton("Colour", &app.previewKind, 0);
+            ImGui::SameLine();
+            ImGui::RadioButton("BW", &app.previewKind, 1);
+            ImGui::SameLine();
+            ImGui::RadioButton("Enhanced", &app.previewKind, 2);
+            availWarp = ImGui::GetContentRegionAvail();
+            const Mat& shown = app.previewKind == 1 && !app.warpedBW.empty() ? app.warpedBW
+                : app.previewKind == 2 && !app.warpedEnhanced.empty() ? app.warpedEnhanced : app.warpedColor;
+
             // compute warped preview size to fit availWarp while preserving aspect ratio
             int maxW = (int)availWarp.x;
             int maxH = (int)availWarp.y;
-            double sx = (double)maxW / app.warpedColor.cols;
-            double sy = (double)maxH / app.warpedColor.rows;
+            double sx = (double)maxW / shown.cols;
+            double sy = (double)maxH / shown.rows;
             double s = min(1.0, min(sx, sy));
-            ImVec2 warpedSize((float)(app.warpedColor.cols * s), (float)(app.warpedColor.rows * s));
+            ImVec2 warpedSize((float)(shown.cols * s), (float)(shown.rows * s));
 
             // update warped texture
             if (texWarped) { glDeleteTextures(1, &texWarped); texWarped = 0; }
-            texWarped = matToTexture(app.warpedColor);
+            texWarped = matToTexture(shown);
 
             // center
             ImVec2 cur = ImGui::GetCursorScreenPos();
@@ -420,6 +822,11 @@ int main(int argc, char** argv) {
         }
         ImGui::End();
 
+        if (showProfiler) {
+            drawProfilerPanel(&showProfiler);
+            if (!showProfiler) Profiler::instance().setEnabled(false);
+        }
+
         // --- Render ---
         ImGui::Render();
         glViewport(0, 0, display_w, display_h);
@@ -429,14 +836,26 @@ int main(int argc, char** argv) {
         glfwSwapBuffers(window);
     }
 
+    if (!listingCacheFile.empty()) {
+        ofstream out(listingCacheFile, ios::binary);
+        out << ImGuiFileDialog::Instance()->SerializeListingCache();
+    }
+
     // cleanup textures
-    if (texPreview) glDeleteTextures(1, &texPreview);
+    viewer.releaseTextures();
+    thumbnails.release();
+    stopLive();
     if (texWarped) glDeleteTextures(1, &texWarped);
+    if (texPagePreview) glDeleteTextures(1, &texPagePreview);
+    session.clear();
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
     glfwDestroyWindow(window);
     glfwTerminate();
+
+    if (!cli.tracePath.empty() && !Tracer::instance().write(cli.tracePath))
+        cerr << "Cannot write trace " << cli.tracePath << endl;
     return 0;
 }
\ No newline at end of file